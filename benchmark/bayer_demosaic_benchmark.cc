@@ -0,0 +1,161 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/bayer_demosaic.h"
+#include "provider_vision/media/work_pool.h"
+
+#ifdef PROVIDER_VISION_X86
+#include <x86intrin.h>
+#endif
+
+using provider_vision::BayerPattern;
+using provider_vision::SimdLevel;
+
+namespace {
+
+struct Timing {
+  double nanoseconds_per_pixel;
+  double cycles_per_pixel;
+};
+
+template <typename Function>
+Timing Measure(const cv::Mat &bayer, int iterations, Function convert) {
+  // The first conversion allocates the image.
+  convert();
+  const auto start = std::chrono::steady_clock::now();
+#ifdef PROVIDER_VISION_X86
+  const unsigned long long start_cycles = __rdtsc();
+#endif
+  for (int i = 0; i < iterations; ++i) {
+    convert();
+  }
+  const double pixels = static_cast<double>(bayer.total()) * iterations;
+  Timing timing;
+#ifdef PROVIDER_VISION_X86
+  timing.cycles_per_pixel = (__rdtsc() - start_cycles) / pixels;
+#else
+  timing.cycles_per_pixel = 0.0;
+#endif
+  timing.nanoseconds_per_pixel =
+      std::chrono::duration<double, std::nano>(
+          std::chrono::steady_clock::now() - start).count() / pixels;
+  return timing;
+}
+
+void Print(const char *name, const Timing &timing, double baseline) {
+  printf("%-14s %6.2f cycles/px %6.3f ns/px  x%.2f\n", name,
+         timing.cycles_per_pixel, timing.nanoseconds_per_pixel,
+         baseline / timing.nanoseconds_per_pixel);
+}
+
+}  // namespace
+
+/**
+ * Compares the bilinear demosaicing kernels with cv::cvtColor on a random
+ * RGGB mosaic, the binning with cv::cvtColor followed by cv::resize, and the
+ * demosaicing and undistortion in a single pass with the demosaicing
+ * followed by cv::remap.
+ *
+ * bayer_demosaic_benchmark [width] [height] [iterations] [threads]
+ *
+ * The default is the 2064x1544 of the front camera on a single thread, so
+ * the cycles per pixel are the ones of a core. OpenCV and the WorkPool get
+ * the same number of threads, the calling thread counting as one of the
+ * pool. The cycles are the ones of the time stamp counter, i.e. at the
+ * nominal frequency of the CPU.
+ */
+int main(int argc, char **argv) {
+  const int width = argc > 1 ? std::atoi(argv[1]) : 2064;
+  const int height = argc > 2 ? std::atoi(argv[2]) : 1544;
+  const int iterations = argc > 3 ? std::atoi(argv[3]) : 50;
+  const int threads = argc > 4 ? std::atoi(argv[4]) : 1;
+  cv::setNumThreads(threads);
+  provider_vision::WorkPool::Instance().SetThreadCount(
+      static_cast<size_t>(std::max(threads - 1, 0)));
+
+  cv::Mat bayer(height, width, CV_8UC1);
+  cv::randu(bayer, 0, 256);
+  cv::Mat bgr;
+
+  printf("%dx%d, %d iterations, %d threads, best kernel: %s\n", width, height,
+         iterations, threads,
+         provider_vision::GetSimdLevelName(provider_vision::GetSimdLevel()));
+
+  const Timing opencv = Measure(bayer, iterations, [&]() {
+    cv::cvtColor(bayer, bgr, CV_BayerBG2BGR);
+  });
+  Print("opencv", opencv, opencv.nanoseconds_per_pixel);
+
+  for (SimdLevel level :
+       {SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2}) {
+    if (provider_vision::ClampSimdLevel(level) != level) {
+      continue;
+    }
+    const Timing timing = Measure(bayer, iterations, [&]() {
+      provider_vision::DemosaicBilinear(bayer, BayerPattern::RGGB, bgr, level);
+    });
+    Print(provider_vision::GetSimdLevelName(level), timing,
+          opencv.nanoseconds_per_pixel);
+  }
+
+  // The half resolution conversion, against the full resolution one followed
+  // by the resize it replaces.
+  cv::Mat half;
+  const Timing resize = Measure(bayer, iterations, [&]() {
+    cv::cvtColor(bayer, bgr, CV_BayerBG2BGR);
+    cv::resize(bgr, half, cv::Size(width / 2, height / 2), 0, 0,
+               cv::INTER_AREA);
+  });
+  Print("opencv+resize", resize, resize.nanoseconds_per_pixel);
+  const Timing binning = Measure(bayer, iterations, [&]() {
+    provider_vision::DemosaicBinning(bayer, BayerPattern::RGGB, half);
+  });
+  Print("binning", binning, resize.nanoseconds_per_pixel);
+
+  // The undistortion of a wide angle lens, centered on the sensor.
+  const double focal = 0.6 * width;
+  const cv::Mat camera_matrix =
+      (cv::Mat_<double>(3, 3) << focal, 0.0, (width - 1) / 2.0, 0.0, focal,
+       (height - 1) / 2.0, 0.0, 0.0, 1.0);
+  const cv::Mat distortion =
+      (cv::Mat_<double>(5, 1) << -0.3, 0.1, 0.0, 0.0, 0.0);
+  cv::Mat map1, map2, undistorted;
+  cv::initUndistortRectifyMap(camera_matrix, distortion, cv::Mat(),
+                              camera_matrix, bayer.size(), CV_16SC2, map1,
+                              map2);
+  const Timing remap = Measure(bayer, iterations, [&]() {
+    provider_vision::DemosaicBilinear(bayer, BayerPattern::RGGB, bgr);
+    cv::remap(bgr, undistorted, map1, map2, cv::INTER_LINEAR,
+              cv::BORDER_CONSTANT);
+  });
+  Print("bilinear+remap", remap, remap.nanoseconds_per_pixel);
+  const Timing fused = Measure(bayer, iterations, [&]() {
+    provider_vision::DemosaicRemap(bayer, BayerPattern::RGGB, map1, map2,
+                                   undistorted);
+  });
+  Print("fused remap", fused, remap.nanoseconds_per_pixel);
+  return 0;
+}
@@ -0,0 +1,123 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <image_transport/image_transport.h>
+#include <ros/ros.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "provider_vision/media/camera/synthetic_media.h"
+#include "provider_vision/media/camera_configuration.h"
+#include "provider_vision/media/latency_histogram.h"
+#include "provider_vision/media/media_streamer.h"
+
+namespace {
+
+struct TopicStatistics {
+  std::atomic<uint64_t> frames;
+  provider_vision::LatencyHistogram latency;
+
+  TopicStatistics() : frames(0), latency() {}
+
+  void Receive(const sensor_msgs::ImageConstPtr &msg) {
+    latency.Record((ros::Time::now() - msg->header.stamp).toSec());
+    ++frames;
+  }
+
+  void Print(const std::string &name, double seconds) {
+    provider_vision::LatencyHistogram::Summary summary = latency.TakeSummary();
+    printf("%-6s %8lu frames %8.1f fps   capture to subscriber: p50 %.2f ms  "
+           "p99 %.2f ms  max %.2f ms\n",
+           name.c_str(), static_cast<unsigned long>(frames.load()),
+           frames / seconds, summary.p50 * 1e3, summary.p99 * 1e3,
+           summary.max * 1e3);
+  }
+};
+
+}  // namespace
+
+/**
+ * Drives a MediaStreamer end to end with a synthetic media and subscribes to
+ * its topics in the same process, as a nodelet would.
+ *
+ * rosrun provider_vision media_streamer_benchmark [media] [mode] [seconds]
+ *                                                 [output]
+ *
+ * The media is a SyntheticMedia name (synthetic_bayer_2048x1536_0 by
+ * default, a frame rate of 0 generates the frames as fast as possible), the
+ * mode is sequential or pipelined and the output is color or raw.
+ * The timings of every stage are published on /diagnostics as well.
+ */
+int main(int argc, char **argv) {
+  ros::init(argc, argv, "media_streamer_benchmark",
+            ros::init_options::AnonymousName);
+  ros::NodeHandle nh("~");
+
+  const std::string media_name =
+      argc > 1 ? argv[1] : "synthetic_bayer_2048x1536_0";
+  const std::string mode = argc > 2 ? argv[2] : "pipelined";
+  const double duration = argc > 3 ? std::atof(argv[3]) : 10.0;
+  const std::string output = argc > 4 ? argv[4] : "color";
+
+  if (!provider_vision::SyntheticMedia::IsSyntheticName(media_name)) {
+    ROS_ERROR("%s is not a synthetic media.", media_name.c_str());
+    return 1;
+  }
+  auto media = std::make_shared<provider_vision::SyntheticMedia>(media_name);
+  media->Open();
+  media->StartStreaming();
+
+  provider_vision::CameraConfiguration config(nh, "benchmark");
+  config.streamer_mode_ = mode;
+  config.output_mode_ = output;
+  config.playback_speed_ = media->GetFrameRate() > 0.0 ? 1.0 : 0.0;
+
+  TopicStatistics color, raw;
+  image_transport::ImageTransport it(nh);
+  image_transport::Subscriber color_subscriber =
+      it.subscribe("image", 10, &TopicStatistics::Receive, &color);
+  image_transport::Subscriber raw_subscriber;
+  if (output == "raw") {
+    raw_subscriber = it.subscribe("image/raw", 10, &TopicStatistics::Receive,
+                                  &raw);
+  }
+
+  ros::AsyncSpinner spinner(2);
+  spinner.start();
+
+  {
+    provider_vision::MediaStreamer streamer(media, config, nh, "image");
+    ros::WallDuration(duration).sleep();
+  }
+
+  spinner.stop();
+  printf("%s, %s, %s output, %.1f s\n", media_name.c_str(), mode.c_str(),
+         output.c_str(), duration);
+  color.Print("color", duration);
+  if (output == "raw") {
+    raw.Print("raw", duration);
+  }
+
+  media->StopStreaming();
+  media->Close();
+  return 0;
+}
@@ -29,10 +29,13 @@ int main(int argc, char **argv) {
   ros::NodeHandle nh("~");
 
   provider_vision::MediaManager mng(nh);
-  while (ros::ok()) {
-    usleep(20000);
-    ros::spinOnce();
-  }
+
+  // The services and the timers are handled as soon as they arrive, by as
+  // many threads as there are cores. The calls on the medias are then
+  // dispatched on the thread of their context (see MediaManager).
+  ros::AsyncSpinner spinner(0);
+  spinner.start();
+  ros::waitForShutdown();
 
   return 0;
 }
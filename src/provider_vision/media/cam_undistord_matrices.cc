@@ -19,9 +19,84 @@
 /// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
 
 #include "provider_vision/media/cam_undistord_matrices.h"
+#include <ros/ros.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "provider_vision/media/work_pool.h"
 
 namespace provider_vision {
 
+namespace {
+
+// The first bytes of a cached map file, with the version of the format.
+const char kMapMagic[8] = {'P', 'V', 'M', 'A', 'P', 0, 0, 1};
+
+// FNV-1a, enough to tell two calibration files apart.
+std::string HashContent(const std::string &content) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : content) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx",
+           static_cast<unsigned long long>(hash));
+  return buffer;
+}
+
+// $ROS_HOME/provider_vision, ~/.ros/provider_vision by default.
+std::string GetCacheDirectory() {
+  const char *ros_home = std::getenv("ROS_HOME");
+  const char *home = std::getenv("HOME");
+  std::string directory;
+  if (ros_home != nullptr) {
+    directory = ros_home;
+  } else if (home != nullptr) {
+    directory = std::string(home) + "/.ros";
+  } else {
+    return "";
+  }
+  mkdir(directory.c_str(), 0755);
+  directory += "/provider_vision";
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    return "";
+  }
+  return directory;
+}
+
+// cv::remap on a band of the image. A band of at most 64K pixels is
+// remapped by OpenCV on the calling thread, the bands are spread on the
+// work pool instead.
+class RemapBody : public cv::ParallelLoopBody {
+ public:
+  RemapBody(const cv::Mat &in, const cv::Mat &map1, const cv::Mat &map2,
+            cv::Mat &out)
+      : in_(in), map1_(map1), map2_(map2), out_(out) {}
+
+  void operator()(const cv::Range &range) const override {
+    cv::Mat out = out_.rowRange(range);
+    cv::remap(in_, out, map1_.rowRange(range), map2_.rowRange(range),
+              cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+  }
+
+ private:
+  const cv::Mat &in_;
+  const cv::Mat &map1_;
+  const cv::Mat &map2_;
+  cv::Mat &out_;
+};
+
+const int kRemapBandPixels = 1 << 16;
+
+}  // namespace
+
 //==============================================================================
 // C / D T O R S   S E C T I O N
 
@@ -57,7 +132,152 @@ void CameraUndistordMatrices::InitMatrices(const std::string &fullPath) {
       matrices_founded_ = true;
       xml_file_path_ = fullPath;
     }
+
+    // The calibration program of OpenCV stores the size of the images.
+    int width = 0, height = 0;
+    if (!fs["image_Width"].empty() && !fs["image_Height"].empty()) {
+      fs["image_Width"] >> width;
+      fs["image_Height"] >> height;
+    }
+    calibration_size_ = cv::Size(width, height);
+  }
+
+  if (matrices_founded_) {
+    // The version of OpenCV is part of the key, the maps it computes may
+    // change from a version to another.
+    std::ifstream file(fullPath.c_str(), std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    calibration_hash_ = HashContent(content + CV_VERSION);
+  }
+  map1_.release();
+  map2_.release();
+  map_size_ = cv::Size();
+}
+
+//------------------------------------------------------------------------------
+//
+bool CameraUndistordMatrices::PrepareMaps(const cv::Size &size) {
+  if (!matrices_founded_ || size.area() == 0) {
+    return false;
+  }
+  if (size == map_size_) {
+    return true;
+  }
+
+  const std::string cache_path = GetCachePath(size);
+  if (!cache_path.empty() && LoadMaps(cache_path, size)) {
+    ROS_INFO("Undistortion maps of %dx%d loaded from %s", size.width,
+             size.height, cache_path.c_str());
+    return true;
+  }
+
+  const cv::Mat camera_matrix = ScaleCameraMatrix(size);
+  cv::initUndistortRectifyMap(camera_matrix, distortion_matrix_, cv::Mat(),
+                              camera_matrix, size, CV_16SC2, map1_, map2_);
+  map_size_ = size;
+  if (!cache_path.empty() && !SaveMaps(cache_path)) {
+    ROS_WARN("Could not cache the undistortion maps in %s",
+             cache_path.c_str());
+  }
+  ROS_INFO("Undistortion maps of %dx%d computed", size.width, size.height);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool CameraUndistordMatrices::Undistort(const cv::Mat &in,
+                                        cv::Mat &out) const {
+  if (map1_.empty() || in.size() != map_size_) {
+    return false;
+  }
+  out.create(map1_.size(), in.type());
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, out.rows), RemapBody(in, map1_, map2_, out),
+      std::max(kRemapBandPixels / out.cols, 1));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+cv::Mat CameraUndistordMatrices::ScaleCameraMatrix(
+    const cv::Size &size) const {
+  cv::Mat camera_matrix = camera_matrix_.clone();
+  if (calibration_size_.area() == 0 || size == calibration_size_) {
+    return camera_matrix;
+  }
+  // The centers of the pixels are scaled, not their corners: a binned pixel
+  // is centered between the four pixels it is made of.
+  const double sx = static_cast<double>(size.width) / calibration_size_.width;
+  const double sy =
+      static_cast<double>(size.height) / calibration_size_.height;
+  camera_matrix.at<double>(0, 0) *= sx;
+  camera_matrix.at<double>(0, 2) =
+      (camera_matrix.at<double>(0, 2) + 0.5) * sx - 0.5;
+  camera_matrix.at<double>(1, 1) *= sy;
+  camera_matrix.at<double>(1, 2) =
+      (camera_matrix.at<double>(1, 2) + 0.5) * sy - 0.5;
+  return camera_matrix;
+}
+
+//------------------------------------------------------------------------------
+//
+std::string CameraUndistordMatrices::GetCachePath(const cv::Size &size) const {
+  const std::string directory = GetCacheDirectory();
+  if (directory.empty() || calibration_hash_.empty()) {
+    return "";
+  }
+  return directory + "/undistortion_" + calibration_hash_ + "_" +
+         std::to_string(size.width) + "x" + std::to_string(size.height) +
+         ".map";
+}
+
+//------------------------------------------------------------------------------
+//
+bool CameraUndistordMatrices::LoadMaps(const std::string &path,
+                                       const cv::Size &size) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  char magic[sizeof(kMapMagic)];
+  int32_t dimensions[2] = {0, 0};
+  if (!file.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMapMagic, sizeof(magic)) != 0 ||
+      !file.read(reinterpret_cast<char *>(dimensions), sizeof(dimensions)) ||
+      dimensions[0] != size.width || dimensions[1] != size.height) {
+    return false;
+  }
+  cv::Mat map1(size, CV_16SC2), map2(size, CV_16UC1);
+  if (!file.read(reinterpret_cast<char *>(map1.data),
+                 map1.total() * map1.elemSize()) ||
+      !file.read(reinterpret_cast<char *>(map2.data),
+                 map2.total() * map2.elemSize())) {
+    return false;
+  }
+  map1_ = map1;
+  map2_ = map2;
+  map_size_ = size;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool CameraUndistordMatrices::SaveMaps(const std::string &path) const {
+  // Written aside and renamed, another node never reads half a file.
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary.c_str(), std::ios::binary);
+    const int32_t dimensions[2] = {map_size_.width, map_size_.height};
+    file.write(kMapMagic, sizeof(kMapMagic));
+    file.write(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+    file.write(reinterpret_cast<const char *>(map1_.data),
+               map1_.total() * map1_.elemSize());
+    file.write(reinterpret_cast<const char *>(map2_.data),
+               map2_.total() * map2_.elemSize());
+    if (!file) {
+      std::remove(temporary.c_str());
+      return false;
+    }
   }
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
 }
 
 }  // namespace provider_vision
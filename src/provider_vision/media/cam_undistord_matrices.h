@@ -29,8 +29,13 @@
 namespace provider_vision {
 
 /**
- * CameraID is a little class to handle the link between GUID and name.
- * We can then identify a camera by its name but the system uses its GUID.
+ * The calibration of a camera, and the undistortion of its images.
+ *
+ * The undistortion maps are computed once per image size, in the fixed point
+ * form of cv::remap (CV_16SC2 and CV_16UC1), and cached on disk, keyed by a
+ * hash of the calibration file, so a restart only reads them. When the
+ * images are smaller than the calibration (i.e. binned), the camera matrix
+ * is scaled to their size.
  */
 class CameraUndistordMatrices {
  public:
@@ -51,6 +56,29 @@ class CameraUndistordMatrices {
 
   void InitMatrices(const std::string &fullPath);
 
+  /**
+   * Computes, or loads from the cache, the maps for the images of the given
+   * size. Nothing is done if the maps are already the ones of this size.
+   *
+   * \return False if there is no calibration.
+   */
+  bool PrepareMaps(const cv::Size &size);
+
+  /**
+   * Undistorts the image with the maps, cv::remap is parallel.
+   *
+   * \return False if the maps are not the ones of the size of the image.
+   */
+  bool Undistort(const cv::Mat &in, cv::Mat &out) const;
+
+  /// The size of the images of the calibration, empty if the calibration
+  /// file does not store it.
+  const cv::Size &GetCalibrationSize() const;
+
+  const cv::Mat &GetMap1() const;
+
+  const cv::Mat &GetMap2() const;
+
   void GetMatrices(cv::Mat &cameraMatrix, cv::Mat &distortionMatrix);
 
   bool IsCorrectionEnable();
@@ -58,6 +86,18 @@ class CameraUndistordMatrices {
   void CorrectInmage(const cv::Mat &in, cv::Mat &out) const;
 
  private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  // The camera matrix for images of the given size.
+  cv::Mat ScaleCameraMatrix(const cv::Size &size) const;
+
+  std::string GetCachePath(const cv::Size &size) const;
+
+  bool LoadMaps(const std::string &path, const cv::Size &size);
+
+  bool SaveMaps(const std::string &path) const;
+
   //==========================================================================
   // P R I V A T E   M E M B E R S
 
@@ -66,6 +106,16 @@ class CameraUndistordMatrices {
   std::string xml_file_path_;
 
   bool matrices_founded_;
+
+  cv::Size calibration_size_;
+
+  // Hash of the calibration file, the key of the cached maps.
+  std::string calibration_hash_;
+
+  // The maps of cv::remap, for the images of map_size_.
+  cv::Mat map1_, map2_;
+
+  cv::Size map_size_;
 };
 
 //==============================================================================
@@ -89,13 +139,31 @@ inline bool CameraUndistordMatrices::IsCorrectionEnable() {
 //
 inline void CameraUndistordMatrices::CorrectInmage(const cv::Mat &in,
                                                    cv::Mat &out) const {
-  if (matrices_founded_) {
-    cv::undistort(in, out, camera_matrix_, distortion_matrix_);
-  } else {
+  if (!matrices_founded_) {
     in.copyTo(out);
+  } else if (!Undistort(in, out)) {
+    cv::undistort(in, out, ScaleCameraMatrix(in.size()), distortion_matrix_);
   }
 }
 
+//------------------------------------------------------------------------------
+//
+inline const cv::Size &CameraUndistordMatrices::GetCalibrationSize() const {
+  return calibration_size_;
+}
+
+//------------------------------------------------------------------------------
+//
+inline const cv::Mat &CameraUndistordMatrices::GetMap1() const {
+  return map1_;
+}
+
+//------------------------------------------------------------------------------
+//
+inline const cv::Mat &CameraUndistordMatrices::GetMap2() const {
+  return map2_;
+}
+
 }  // namespace provider_vision
 
 #endif  // PROVIDER_VISION_MEDIA_UNDISTORD_MATRICES_H_
@@ -25,6 +25,8 @@
 #include <memory>
 #include <opencv2/core/core.hpp>
 #include "provider_vision/config.h"
+#include "provider_vision/media/frame.h"
+#include "provider_vision/media/frame_pool.h"
 
 namespace provider_vision {
 
@@ -45,7 +47,7 @@ class BaseMedia {
   // P U B L I C   C / D T O R S
 
   explicit BaseMedia(const std::string &name)
-      : status_(Status::CLOSE), media_name_(name) {}
+      : status_(Status::CLOSE), media_name_(name), raw_pool_() {}
 
   virtual ~BaseMedia() = default;
 
@@ -84,6 +86,47 @@ class BaseMedia {
    */
   virtual void NextImageCopy(cv::Mat &image);
 
+  /**
+   * Acquire the next frame as the device delivers it, without converting it.
+   * This is the acquisition stage of the MediaStreamer.
+   *
+   * By default, the media does not need any conversion and the raw image
+   * is simply the next image.
+   * When the raw image is acquired in a buffer of the pool of the media, the
+   * raw message of the frame is the message owning this buffer.
+   */
+  virtual bool NextFrame(Frame &frame);
+
+  /**
+   * Convert the raw image of a frame acquired with NextFrame to BGR.
+   * This is the conversion stage of the MediaStreamer, it can be called on
+   * another thread than NextFrame and must not access the device.
+   */
+  virtual bool ConvertFrame(Frame &frame) const;
+
+  /**
+   * Whether ConvertUndistortedFrame is implemented, i.e. whether the
+   * conversion can undistort the image in the same pass. The converted image
+   * must then have the size of the raw image.
+   */
+  virtual bool CanFuseUndistortion() const;
+
+  /**
+   * Same as ConvertFrame, and undistorts the image in the same pass with the
+   * maps of cv::remap (see CameraUndistordMatrices). The streamer only calls
+   * it when CanFuseUndistortion returns true, and remaps the converted image
+   * otherwise.
+   */
+  virtual bool ConvertUndistortedFrame(Frame &frame, const cv::Mat &map1,
+                                       const cv::Mat &map2) const;
+
+  /**
+   * The sensor_msgs encoding of the raw images returned by NextFrame.
+   * An empty string means that the raw image is already the converted image
+   * and that there is nothing more to publish about it.
+   */
+  virtual std::string GetRawEncoding() const;
+
   /**
    * Returns the current camera Status
    */
@@ -95,6 +138,12 @@ class BaseMedia {
    */
   virtual bool HasArtificialFramerate() const;
 
+  /**
+   * The frame rate at which the media was recorded, for the medias that have
+   * an artificial frame rate. 0 if the media does not know it.
+   */
+  virtual double GetFrameRate() const;
+
   const std::string &GetName() const;
 
   bool IsOpened() const;
@@ -123,6 +172,12 @@ class BaseMedia {
   Status status_;
 
   std::string media_name_;
+
+  /**
+   * The buffers in which NextFrame acquires the raw images. A media sizes it
+   * when it is opened, so the acquisition does not allocate while streaming.
+   */
+  FramePool raw_pool_;
 };
 
 //==============================================================================
@@ -136,6 +191,35 @@ inline void BaseMedia::NextImageCopy(cv::Mat &image) {
   image = tmp_image.clone();
 }
 
+//------------------------------------------------------------------------------
+//
+inline bool BaseMedia::NextFrame(Frame &frame) {
+  return NextImage(frame.raw);
+}
+
+//------------------------------------------------------------------------------
+//
+inline bool BaseMedia::ConvertFrame(Frame &frame) const {
+  frame.image = frame.raw;
+  return !frame.image.empty();
+}
+
+//------------------------------------------------------------------------------
+//
+inline bool BaseMedia::CanFuseUndistortion() const { return false; }
+
+//------------------------------------------------------------------------------
+//
+inline bool BaseMedia::ConvertUndistortedFrame(Frame &frame,
+                                               const cv::Mat &map1,
+                                               const cv::Mat &map2) const {
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//
+inline std::string BaseMedia::GetRawEncoding() const { return ""; }
+
 //------------------------------------------------------------------------------
 //
 inline const BaseMedia::Status &BaseMedia::GetStatus() const {
@@ -146,6 +230,10 @@ inline const BaseMedia::Status &BaseMedia::GetStatus() const {
 //
 inline bool BaseMedia::HasArtificialFramerate() const { return true; }
 
+//------------------------------------------------------------------------------
+//
+inline double BaseMedia::GetFrameRate() const { return 0.0; }
+
 //------------------------------------------------------------------------------
 //
 inline const std::string &BaseMedia::GetName() const { return media_name_; }
@@ -20,7 +20,11 @@
 
 #include "provider_vision/media/camera/dc1394_camera.h"
 #include <ros/ros.h>
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include "provider_vision/media/conversion/yuv422.h"
+#include "provider_vision/media/device_clock.h"
 
 namespace provider_vision {
 
@@ -33,7 +37,14 @@ const char *DC1394Camera::CAM_TAG = "[DC1394 Camera]";
 //
 DC1394Camera::DC1394Camera(dc1394camera_t *camera,
                            const CameraConfiguration &config)
-    : BaseCamera(config), dc1394_camera_(camera), calibrate_count_(0) {}
+    : BaseCamera(config),
+      dc1394_camera_(camera),
+      last_frame_time_(0),
+      calibrate_count_(0),
+      frame_interval_(0.0),
+      keep_latest_(true),
+      last_timestamp_(0),
+      sequence_(-1) {}
 
 //------------------------------------------------------------------------------
 //
@@ -56,15 +67,49 @@ bool DC1394Camera::Open() {
   std::lock_guard<std::mutex> guard(cam_access_);
 
   bool opening_result = SetFormat7();
-  err = dc1394_capture_setup(dc1394_camera_, DMA_BUFFER,
+  const int buffer_count = std::max(buffer_count_, MIN_BUFFER_COUNT);
+  err = dc1394_capture_setup(dc1394_camera_, static_cast<uint32_t>(buffer_count),
                              DC1394_CAPTURE_FLAGS_DEFAULT);
 
+  keep_latest_ = true;
+  if (buffer_mode_ == "every") {
+    keep_latest_ = false;
+  } else if (buffer_mode_ != "latest") {
+    ROS_WARN_NAMED(CAM_TAG, "Unknown buffer mode %s, using latest",
+                   buffer_mode_.c_str());
+  }
+  ROS_INFO_NAMED(CAM_TAG, "%s: DMA ring of %d buffers in %s mode",
+                 media_name_.c_str(), buffer_count,
+                 keep_latest_ ? "latest" : "every");
+
   if (err != DC1394_SUCCESS) {
     ROS_ERROR_NAMED(CAM_TAG, "Error on opening camera %s : %s",
                     media_name_.c_str(), dc1394_error_get_string(err));
     opening_result = false;
   }
 
+  // The YUV images are copied out of the DMA buffers in these ones.
+  uint32_t width = 0, height = 0;
+  if (opening_result &&
+      dc1394_get_image_size_from_video_mode(
+          dc1394_camera_, DC1394_VIDEO_MODE_FORMAT7_0, &width, &height) ==
+          DC1394_SUCCESS) {
+    raw_pool_.Resize(static_cast<size_t>(frame_pool_size_));
+    raw_pool_.Reserve(static_cast<int>(height), static_cast<int>(width),
+                      CV_8UC2);
+  }
+
+  // The lost frames are detected from the gap between two timestamps.
+  float interval = 0.0f;
+  if (dc1394_format7_get_frame_interval(dc1394_camera_,
+                                        DC1394_VIDEO_MODE_FORMAT7_0,
+                                        &interval) == DC1394_SUCCESS &&
+      interval > 0.0f) {
+    frame_interval_ = interval;
+  } else {
+    frame_interval_ = 1.0 / (framerate_ > 0.0 ? framerate_ : 15.0);
+  }
+
   opening_result ? status_ = Status::OPEN : status_ = Status::ERROR;
   return opening_result;
 }
@@ -109,6 +154,8 @@ bool DC1394Camera::SetStreamingModeOn() {
     ROS_ERROR_NAMED(CAM_TAG, "The media could not be started: %s",
                     dc1394_error_get_string(error));
   }
+  sequence_ = -1;
+  FeedWatchdog();
   result ? status_ = Status::STREAMING : status_ = Status::ERROR;
   return result;
 }
@@ -128,48 +175,81 @@ bool DC1394Camera::SetStreamingModeOff() {
   }
 
   result ? status_ = Status::OPEN : status_ = Status::ERROR;
-  // Here stopping timer just in case... Should already be closed....
-  std::lock_guard<std::mutex> guard2(timer_access_);
-  try {
-    acquisition_timer_.Pause();
-    acquisition_timer_.Reset();
-  } catch (std::exception &e) {
-    ROS_ERROR_NAMED(CAM_TAG, "Exception on timer handling %s", e.what());
-  }
+  last_frame_time_ = 0;
   return result;
 }
 
 //------------------------------------------------------------------------------
 //
 bool DC1394Camera::NextImage(cv::Mat &img) {
-  dc1394video_frame_t *frame = nullptr;
-  dc1394error_t error;
+  Frame frame;
+  if (!NextFrame(frame) || !ConvertFrame(frame)) {
+    return false;
+  }
+  img = frame.image;
+  return true;
+}
 
-  timer_access_.lock();
-  acquisition_timer_.Sleep(3);
-  acquisition_timer_.Start();
-  timer_access_.unlock();
+//------------------------------------------------------------------------------
+//
+bool DC1394Camera::NextFrame(Frame &frame) {
+  dc1394video_frame_t *dc_frame = nullptr;
+  dc1394error_t error;
 
-  cam_access_.lock();
+  // The dequeue returns as soon as the DMA ring holds a frame. It does not
+  // hold cam_access_: the capture goes through its own file descriptor, so
+  // the features can be changed while the acquisition waits on a frame.
   error = dc1394_capture_dequeue(dc1394_camera_, DC1394_CAPTURE_POLICY_WAIT,
-                                 &frame);
-  cam_access_.unlock();
-  timer_access_.lock();
-  atlas::MilliTimer::Sleep(3);
-  timer_access_.unlock();
+                                 &dc_frame);
 
   /// Here we take exactly the camera1394 method... it works so... :P
-  if (error != DC1394_SUCCESS || frame == nullptr) {
+  if (error != DC1394_SUCCESS || dc_frame == nullptr) {
     status_ = Status::ERROR;
     ROS_ERROR_NAMED(CAM_TAG, "Error on image acquisition %s",
                     dc1394_error_get_string(error));
     return false;
   }
 
+  if (keep_latest_) {
+    // The frames behind this one are more recent: they are polled until the
+    // ring is empty and the stale buffers go back to it right away. The
+    // skipped frames show as a gap in the sequence, which the streamer
+    // reports as dropped.
+    while (dc_frame->frames_behind > 0) {
+      dc1394video_frame_t *newer_frame = nullptr;
+      error = dc1394_capture_dequeue(dc1394_camera_, DC1394_CAPTURE_POLICY_POLL,
+                                     &newer_frame);
+      if (error != DC1394_SUCCESS || newer_frame == nullptr) {
+        break;
+      }
+      error = dc1394_capture_enqueue(dc1394_camera_, dc_frame);
+      if (error != DC1394_SUCCESS) {
+        status_ = Status::ERROR;
+        ROS_ERROR_NAMED(CAM_TAG, "Error on image acquisition %s",
+                        dc1394_error_get_string(error));
+        return false;
+      }
+      dc_frame = newer_frame;
+    }
+  }
+
+  // The timestamp is the host time, in microseconds, at which the DMA
+  // transfer of the frame completed.
+  frame.info.stamp.fromNSec(dc_frame->timestamp * 1000);
+  frame.info.sequence = CountFrames(dc_frame->timestamp);
+  frame.info.frames_behind = dc_frame->frames_behind;
+  FeedWatchdog();
+
   try {
-    cv::Mat tmp =
-        cv::Mat(frame->size[1], frame->size[0], CV_8UC2, frame->image);
-    cv::cvtColor(tmp, img, CV_YUV2BGR_Y422);
+    // The DMA buffer goes back to the ring right after, so the YUV image
+    // must be copied before it goes to the conversion stage. It is copied in
+    // a buffer of the pool, which is also the raw message if it gets
+    // published.
+    frame.raw_message = raw_pool_.Acquire(dc_frame->size[1], dc_frame->size[0],
+                                          CV_8UC2, frame.raw);
+    cv::Mat tmp = cv::Mat(dc_frame->size[1], dc_frame->size[0], CV_8UC2,
+                          dc_frame->image);
+    tmp.copyTo(frame.raw);
   } catch (cv::Exception &e) {
     status_ = Status::ERROR;
     ROS_ERROR_NAMED(CAM_TAG, "Error on OpenCV image transformation %s",
@@ -178,9 +258,7 @@ bool DC1394Camera::NextImage(cv::Mat &img) {
   }
 
   // Clean, prepare for new frame.
-  cam_access_.lock();
-  error = dc1394_capture_enqueue(dc1394_camera_, frame);
-  cam_access_.unlock();
+  error = dc1394_capture_enqueue(dc1394_camera_, dc_frame);
   if (error != DC1394_SUCCESS) {
     status_ = Status::ERROR;
     ROS_ERROR_NAMED(CAM_TAG, "Error on image acquisition %s",
@@ -188,7 +266,7 @@ bool DC1394Camera::NextImage(cv::Mat &img) {
     return false;
   }
 
-  if (img.empty() || img.size().height == 0 || img.size().height == 0) {
+  if (frame.raw.empty()) {
     ROS_ERROR_NAMED(CAM_TAG,
                     "The image is empty, there is a problem with the media");
     return false;
@@ -197,6 +275,29 @@ bool DC1394Camera::NextImage(cv::Mat &img) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+//
+bool DC1394Camera::ConvertFrame(Frame &frame) const {
+  try {
+    if (!ConvertUyvyToBgr(frame.raw, frame.image)) {
+      ROS_ERROR_NAMED(CAM_TAG, "The raw image is not a YUV422 image");
+      return false;
+    }
+  } catch (cv::Exception &e) {
+    ROS_ERROR_NAMED(CAM_TAG, "Error on OpenCV image transformation %s",
+                    e.what());
+    return false;
+  }
+
+  if (frame.image.empty() || frame.image.size().height == 0 ||
+      frame.image.size().width == 0) {
+    ROS_ERROR_NAMED(CAM_TAG,
+                    "The image is empty, there is a problem with the media");
+    return false;
+  }
+  return true;
+}
+
 //------------------------------------------------------------------------------
 //
 bool DC1394Camera::GetGainMode(bool &value) const {
@@ -619,6 +720,21 @@ bool DC1394Camera::GetWhiteBalanceBlue(double &value) const {
   return true;
 }
 
+//------------------------------------------------------------------------------
+//
+int64_t DC1394Camera::CountFrames(uint64_t timestamp) {
+  if (sequence_ < 0 || timestamp <= last_timestamp_) {
+    sequence_ = 0;
+  } else {
+    // The camera has no frame counter, the count is made from the gap
+    // between the timestamps.
+    sequence_ += GetFrameCountDelta(last_timestamp_, timestamp,
+                                    frame_interval_);
+  }
+  last_timestamp_ = timestamp;
+  return sequence_;
+}
+
 //------------------------------------------------------------------------------
 //
 uint32_t DC1394Camera::ConvertFramerateToEnum(float val) const {
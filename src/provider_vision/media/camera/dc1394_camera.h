@@ -24,6 +24,8 @@
 #include <dc1394/dc1394.h>
 #include <lib_atlas/sys/timer.h>
 #include <sensor_msgs/image_encodings.h>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <opencv2/opencv.hpp>
@@ -36,7 +38,8 @@ namespace provider_vision {
 
 class DC1394Camera : public BaseCamera {
  public:
-  static const int DMA_BUFFER = 4;
+  // The DMA ring needs a buffer to fill while one is being read.
+  static const int MIN_BUFFER_COUNT = 2;
 
   static const char *CAM_TAG;
 
@@ -67,6 +70,15 @@ class DC1394Camera : public BaseCamera {
 
   bool NextImage(cv::Mat &img) override;
 
+  // Dequeues the next YUV422 buffer of the camera and copies it in the raw
+  // image of the frame.
+  bool NextFrame(Frame &frame) override;
+
+  // Converts the YUV422 raw image of the frame to BGR.
+  bool ConvertFrame(Frame &frame) const override;
+
+  std::string GetRawEncoding() const override;
+
   // Sets to different streaming format.
   bool SetFormat7();
 
@@ -79,6 +91,8 @@ class DC1394Camera : public BaseCamera {
 
   std::string GetModel() const;
 
+  // Seconds since the last frame was received, 0 when the camera is not
+  // streaming. Used by the watchdog of the context.
   double GetAcquistionTimerValue() const;
 
   // SHOULD BE USE ONLY BY DRIVER WITH CAUTION
@@ -134,6 +148,12 @@ class DC1394Camera : public BaseCamera {
   //==========================================================================
   // P R I V A T E   M E T H O D S
 
+  // Turns the timestamp of a frame in a frame counter.
+  int64_t CountFrames(uint64_t timestamp);
+
+  // Sets the time of the last frame to now, for the watchdog.
+  void FeedWatchdog();
+
   // float to enum
   uint32_t ConvertFramerateToEnum(float val) const;
 
@@ -145,13 +165,27 @@ class DC1394Camera : public BaseCamera {
 
   mutable std::mutex cam_access_;
 
-  mutable std::mutex timer_access_;
-
   dc1394camera_t *dc1394_camera_;
 
-  atlas::MilliTimer acquisition_timer_;
+  // Steady clock time of the last frame, in nanoseconds, or 0 when not
+  // streaming. The acquisition only stores it, so the watchdog never blocks
+  // the capture and the capture never waits on a lock.
+  std::atomic<int64_t> last_frame_time_;
 
   uint16_t calibrate_count_;
+
+  // Seconds between two frames of the camera.
+  double frame_interval_;
+
+  // Whether the acquisition drains the DMA ring to its newest frame
+  // ("latest" buffer mode) or reads every frame in order ("every" mode).
+  bool keep_latest_;
+
+  // Only accessed by NextFrame, and by SetStreamingModeOn before the
+  // acquisition starts.
+  uint64_t last_timestamp_;
+
+  int64_t sequence_;
 };
 
 //==============================================================================
@@ -170,11 +204,23 @@ inline std::string DC1394Camera::GetModel() const {
 //------------------------------------------------------------------------------
 //
 inline double DC1394Camera::GetAcquistionTimerValue() const {
-  timer_access_.lock();
-  double timer = acquisition_timer_.Time();
-  timer_access_.unlock();
-  return timer;
-};
+  const int64_t last_frame_time = last_frame_time_.load();
+  if (last_frame_time == 0) {
+    return 0.0;
+  }
+  const std::chrono::nanoseconds now =
+      std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double>(
+             now - std::chrono::nanoseconds(last_frame_time)).count();
+}
+
+//------------------------------------------------------------------------------
+//
+inline void DC1394Camera::FeedWatchdog() {
+  last_frame_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+}
 
 //------------------------------------------------------------------------------
 //
@@ -182,6 +228,13 @@ inline dc1394camera_t *DC1394Camera::GetCameraPtr() const {
   return dc1394_camera_;
 }
 
+//------------------------------------------------------------------------------
+//
+inline std::string DC1394Camera::GetRawEncoding() const {
+  // The Format7 ROI is set in YUV422, which is UYVY for the IIDC cameras.
+  return sensor_msgs::image_encodings::YUV422;
+}
+
 }  // namespace provider_vision
 
 #endif  // PROVIDER_VISION_MEDIA_CAMERA_DC1394_CAMERA_H_
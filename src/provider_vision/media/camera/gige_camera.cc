@@ -22,6 +22,9 @@
 #ifndef OS_DARWIN
 
 #include <ros/ros.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include "provider_vision/media/camera/gige_camera.h"
 
@@ -35,14 +38,30 @@ const char *GigeCamera::CAM_TAG = "[GigE Camera]";
 //------------------------------------------------------------------------------
 //
 GigeCamera::GigeCamera(const CameraConfiguration &config)
-    : BaseCamera(config), gige_camera_(nullptr) {}
+    : BaseCamera(config),
+      gige_camera_(nullptr),
+      ring_(),
+      keep_latest_(true),
+      lease_buffers_(false),
+      binning_(config.conversion_ == "binning"),
+      last_frame_time_(0),
+      device_clock_(),
+      last_block_id_(-1),
+      sequence_(0) {
+  if (conversion_ != "full" && conversion_ != "binning") {
+    ROS_WARN_NAMED(CAM_TAG, "Unknown conversion %s, using full",
+                   conversion_.c_str());
+  }
+}
 
 //------------------------------------------------------------------------------
 //
 GigeCamera::~GigeCamera() {
+  RevokeLeases();
   GevAbortImageTransfer(&gige_camera_);
   GevFreeImageTransfer(&gige_camera_);
   GevCloseCamera(&gige_camera_);
+  FreeBuffers();
   GevApiInitialize();
   _CloseSocketAPI();
 }
@@ -114,17 +133,53 @@ bool GigeCamera::Open() {
 
     UINT32 maxDepth = GetPixelSizeInBytes(format);
 
-    // Allocate image buffers
+    // In the asynchronous mode, the driver cycles through the buffers
+    // without waiting for them to be released, and NextFrame skips to the
+    // newest one. In the synchronous mode, a buffer is only filled again once
+    // NextFrame released it, so no frame is overwritten before it is read.
+    GevBufferCyclingMode cycling_mode = Asynchronous;
+    keep_latest_ = true;
+    if (buffer_mode_ == "every") {
+      cycling_mode = SynchronousNextEmpty;
+      keep_latest_ = false;
+    } else if (buffer_mode_ != "latest") {
+      ROS_WARN_NAMED(CAM_TAG, "Unknown buffer mode %s, using latest",
+                     buffer_mode_.c_str());
+    }
+
+    // A buffer handed down the pipeline must not be filled again before it
+    // is given back, which only the synchronous mode guarantees.
+    lease_buffers_ = zero_copy_ && !keep_latest_;
+    if (zero_copy_ && keep_latest_) {
+      ROS_WARN_NAMED(CAM_TAG,
+                     "Zero copy needs the every buffer mode, copying frames");
+    }
 
-    PUINT8 bufAddress[DMA_BUFFER];
+    AllocateBuffers(maxDepth * width * height);
+    status = GevInitImageTransfer(gige_camera_, cycling_mode,
+                                  static_cast<UINT32>(ring_->buffers.size()),
+                                  ring_->buffers.data());
+    ROS_INFO_NAMED(CAM_TAG, "%lu buffers of %u bytes in %s mode%s",
+                   ring_->buffers.size(), maxDepth * width * height,
+                   keep_latest_ ? "latest" : "every",
+                   lease_buffers_ ? ", zero copy" : "");
+
+    // Unless they are leased, the Bayer images are copied out of the driver
+    // buffers in these ones.
+    if (!lease_buffers_) {
+      raw_pool_.Resize(static_cast<size_t>(frame_pool_size_));
+      raw_pool_.Reserve(height, width, CV_8UC1);
+    }
 
-    UINT32 size = maxDepth * width * height;
-    for (int i = 0; i < DMA_BUFFER; i++) {
-      bufAddress[i] = (PUINT8)malloc(size);
-      memset(bufAddress[i], 0, size);
+    // The timestamps of the buffers are in ticks of the camera.
+    GenApi::CNodeMapRef *Camera =
+        static_cast<GenApi::CNodeMapRef *>(GevGetFeatureNodeMap(gige_camera_));
+    GenApi::CIntegerPtr ptrIntNode =
+        Camera->_GetNode("GevTimestampTickFrequency");
+    if (ptrIntNode) {
+      device_clock_.SetTickFrequency(
+          static_cast<double>(ptrIntNode->GetValue()));
     }
-    status = GevInitImageTransfer(gige_camera_, Asynchronous, DMA_BUFFER,
-                                  bufAddress);
   } catch (std::exception &e) {
     ROS_ERROR_NAMED(CAM_TAG,
                     "Error while opening the camera. GIGE: %s EXECPTION: %s",
@@ -150,7 +205,10 @@ bool GigeCamera::Close() {
     close_result = StopStreaming();
   }
 
+  RevokeLeases();
+  GevFreeImageTransfer(gige_camera_);
   GEV_STATUS status = GevCloseCamera(&gige_camera_);
+  FreeBuffers();
 
   if (status != GEVLIB_OK) {
     close_result = false;
@@ -178,6 +236,10 @@ bool GigeCamera::SetStreamingModeOn() {
     return false;
   }
 
+  // The block ids start over with the transfer.
+  last_block_id_ = -1;
+  device_clock_.Reset();
+  FeedWatchdog();
   status_ = Status::STREAMING;
   return true;
 }
@@ -202,58 +264,183 @@ bool GigeCamera::SetStreamingModeOff() {
   }
 
   status_ = Status::OPEN;
-  // Here stopping timer just in case... Should already be closed....
-  std::lock_guard<std::mutex> guard2(timer_access_);
-  try {
-    acquisition_timer_.Pause();
-    acquisition_timer_.Reset();
-  } catch (std::exception &e) {
-    ROS_ERROR_NAMED(CAM_TAG, "Exception on timer handling %s", e.what());
-  }
+  last_frame_time_ = 0;
   return true;
 }
 
 //------------------------------------------------------------------------------
 //
 bool GigeCamera::NextImage(cv::Mat &img) {
-  GEV_BUFFER_OBJECT *frame = NULL;
-  timer_access_.lock();
-  acquisition_timer_.Sleep(3);
-  acquisition_timer_.Start();
-  timer_access_.unlock();
+  Frame frame;
+  if (!NextFrame(frame) || !ConvertFrame(frame)) {
+    return false;
+  }
+  img = frame.image;
+  return true;
+}
 
-  cam_access_.lock();
+//------------------------------------------------------------------------------
+//
+bool GigeCamera::NextFrame(Frame &frame) {
+  GEV_BUFFER_OBJECT *frame_buffer = NULL;
+
+  // The wait returns as soon as a buffer is ready. It does not hold
+  // cam_access_: the SDK serializes the register accesses itself, so the
+  // features can be changed while the acquisition waits on a frame.
   GEV_STATUS status;
   try {
-    status = GevWaitForNextImage(gige_camera_, &frame, 1000);
+    status = GevWaitForNextImage(gige_camera_, &frame_buffer, 1000);
   } CATCH_GENAPI_ERROR(status) {
   }
 
-  cam_access_.unlock();
-  timer_access_.lock();
-  atlas::MilliTimer::Sleep(3);
-  timer_access_.unlock();
+  const ros::Time received = ros::Time::now();
 
-  if (status != GEV_STATUS_SUCCESS || frame == nullptr) {
+  if (status != GEV_STATUS_SUCCESS || frame_buffer == nullptr) {
     status_ = Status::ERROR;
     ROS_ERROR_NAMED(CAM_TAG, "Cannot get next image. Status is: %d", status);
     return false;
   }
 
-  if (frame != NULL) {
-    try {
-      cv::Mat tmp = cv::Mat(frame->h, frame->w, CV_8UC1, frame->address);
-      tmp.copyTo(img);
-      cv::cvtColor(tmp, img, CV_BayerRG2RGB);
-    } catch (cv::Exception &e) {
-      status_ = Status::ERROR;
-      ROS_ERROR_NAMED(CAM_TAG, "Error on opencv image transformation %s",
-                      e.what());
+  if (keep_latest_) {
+    // The frames that were waiting behind this one are more recent, the
+    // stale buffers go back to the driver right away. The skipped frames
+    // show as a gap in the block ids.
+    GEV_BUFFER_OBJECT *newer_buffer = nullptr;
+    while (GevWaitForNextImage(gige_camera_, &newer_buffer, 0) ==
+               GEV_STATUS_SUCCESS &&
+           newer_buffer != nullptr) {
+      GevReleaseImage(gige_camera_, frame_buffer);
+      frame_buffer = newer_buffer;
+      newer_buffer = nullptr;
+    }
+  }
+
+  const uint64_t ticks =
+      (static_cast<uint64_t>(frame_buffer->timestamp_hi) << 32) |
+      frame_buffer->timestamp_lo;
+  frame.info.stamp = device_clock_.ToRosTime(ticks, received);
+  frame.info.sequence = UnwrapBlockId(frame_buffer->id);
+  FeedWatchdog();
+
+  if (lease_buffers_) {
+    // The raw image points in the buffer of the driver. It is given back
+    // when the last copy of the lease is released, i.e. once the streamer
+    // converted the frame (and copied it in the raw message if it is
+    // published).
+    std::shared_ptr<BufferRing> ring = ring_;
+    frame.lease = std::shared_ptr<void>(
+        frame_buffer, [ring](GEV_BUFFER_OBJECT *buffer) {
+          std::lock_guard<std::mutex> guard(ring->access);
+          if (ring->transferring) {
+            GevReleaseImage(ring->camera, buffer);
+          }
+        });
+    frame.raw = cv::Mat(frame_buffer->h, frame_buffer->w, CV_8UC1,
+                        frame_buffer->address);
+    frame.raw_message.reset();
+    return !frame.raw.empty();
+  }
+
+  bool copied = true;
+  try {
+    // The driver will reuse its buffer, the Bayer image must be copied
+    // before it goes to the conversion stage. It is copied in a buffer of
+    // the pool, which is also the raw message if it gets published.
+    frame.raw_message = raw_pool_.Acquire(frame_buffer->h, frame_buffer->w,
+                                          CV_8UC1, frame.raw);
+    cv::Mat tmp = cv::Mat(frame_buffer->h, frame_buffer->w, CV_8UC1,
+                          frame_buffer->address);
+    tmp.copyTo(frame.raw);
+  } catch (cv::Exception &e) {
+    status_ = Status::ERROR;
+    ROS_ERROR_NAMED(CAM_TAG, "Error on opencv image transformation %s",
+                    e.what());
+    copied = false;
+  }
+
+  // The buffer can be filled again, which the synchronous mode waits for.
+  GevReleaseImage(gige_camera_, frame_buffer);
+  if (!copied) {
+    return false;
+  }
+
+  if (frame.raw.empty()) {
+    ROS_ERROR_NAMED(CAM_TAG,
+                    "The image is empty, there is a problem with the media");
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+int64_t GigeCamera::UnwrapBlockId(uint64_t block_id) {
+  const int64_t id = static_cast<int64_t>(block_id);
+  if (last_block_id_ >= 0) {
+    sequence_ += GetBlockIdDelta(static_cast<uint64_t>(last_block_id_),
+                                 block_id);
+  }
+  last_block_id_ = id;
+  return sequence_;
+}
+
+//------------------------------------------------------------------------------
+//
+void GigeCamera::AllocateBuffers(size_t size) {
+  RevokeLeases();
+  FreeBuffers();
+  ring_ = std::make_shared<BufferRing>();
+  ring_->camera = gige_camera_;
+  ring_->transferring = true;
+  const int count = std::max(buffer_count_, MIN_BUFFER_COUNT);
+  for (int i = 0; i < count; ++i) {
+    PUINT8 buffer = static_cast<PUINT8>(malloc(size));
+    memset(buffer, 0, size);
+    ring_->buffers.push_back(buffer);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void GigeCamera::RevokeLeases() {
+  if (ring_) {
+    std::lock_guard<std::mutex> guard(ring_->access);
+    ring_->transferring = false;
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void GigeCamera::FreeBuffers() { ring_.reset(); }
+
+//------------------------------------------------------------------------------
+//
+GigeCamera::BufferRing::~BufferRing() {
+  for (auto &buffer : buffers) {
+    free(buffer);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+bool GigeCamera::ConvertFrame(Frame &frame) const {
+  try {
+    const bool converted =
+        binning_
+            ? DemosaicBinning(frame.raw, BayerPattern::RGGB, frame.image)
+            : DemosaicBilinear(frame.raw, BayerPattern::RGGB, frame.image);
+    if (!converted) {
+      ROS_ERROR_NAMED(CAM_TAG, "The raw image is not a Bayer mosaic");
       return false;
     }
+  } catch (cv::Exception &e) {
+    ROS_ERROR_NAMED(CAM_TAG, "Error on opencv image transformation %s",
+                    e.what());
+    return false;
   }
 
-  if (img.empty() || img.size().height == 0 || img.size().height == 0) {
+  if (frame.image.empty() || frame.image.size().height == 0 ||
+      frame.image.size().width == 0) {
     ROS_ERROR_NAMED(CAM_TAG,
                     "The image is empty, there is a problem with the media");
     return false;
@@ -261,6 +448,24 @@ bool GigeCamera::NextImage(cv::Mat &img) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+//
+bool GigeCamera::ConvertUndistortedFrame(Frame &frame, const cv::Mat &map1,
+                                         const cv::Mat &map2) const {
+  try {
+    if (!DemosaicRemap(frame.raw, BayerPattern::RGGB, map1, map2,
+                       frame.image)) {
+      ROS_ERROR_NAMED(CAM_TAG, "The raw image is not a Bayer mosaic");
+      return false;
+    }
+  } catch (cv::Exception &e) {
+    ROS_ERROR_NAMED(CAM_TAG, "Error on opencv image transformation %s",
+                    e.what());
+    return false;
+  }
+  return !frame.image.empty();
+}
+
 //------------------------------------------------------------------------------
 //
 bool GigeCamera::SetCameraParams() {
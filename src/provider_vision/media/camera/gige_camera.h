@@ -25,19 +25,25 @@
 #include <gevapi.h>
 #include <lib_atlas/sys/timer.h>
 #include <sensor_msgs/image_encodings.h>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <vector>
 #include "provider_vision/media/camera/base_camera.h"
 #include "provider_vision/media/camera/base_media.h"
+#include "provider_vision/media/conversion/bayer_demosaic.h"
 #include "provider_vision/media/context/base_context.h"
+#include "provider_vision/media/device_clock.h"
 
 namespace provider_vision {
 
     class GigeCamera : public BaseCamera {
     public:
-        static const int DMA_BUFFER = 4;
+        /// The driver needs a buffer to fill while one is being read.
+        static const int MIN_BUFFER_COUNT = 2;
         static constexpr float FPS = 15;
 
         static const char *CAM_TAG;
@@ -68,6 +74,26 @@ namespace provider_vision {
 
         bool NextImage(cv::Mat &img) override;
 
+        /// Waits for the next Bayer buffer of the camera and copies it in the
+        /// raw image of the frame.
+        bool NextFrame(Frame &frame) override;
+
+        /// Debayers the raw image of the frame, at full or half resolution
+        /// (see conversion_).
+        bool ConvertFrame(Frame &frame) const override;
+
+        /// Only at full resolution.
+        bool CanFuseUndistortion() const override;
+
+        /// Demosaics and undistorts the raw image of the frame in a single
+        /// pass, the BGR image of the whole sensor never goes to the memory.
+        bool ConvertUndistortedFrame(Frame &frame, const cv::Mat &map1,
+                                     const cv::Mat &map2) const override;
+
+        std::string GetRawEncoding() const override;
+
+        /// Seconds since the last frame was received, 0 when the camera is not
+        /// streaming. Used by the watchdog of the context.
         double GetAcquistionTimerValue() const;
 
     protected:
@@ -152,6 +178,24 @@ namespace provider_vision {
 
         bool SetCameraParams();
 
+        /// Turns the block id of a buffer in a frame counter that does not
+        /// wrap.
+        int64_t UnwrapBlockId(uint64_t block_id);
+
+        /// Sets the time of the last frame to now, for the watchdog.
+        void FeedWatchdog();
+
+        /// Allocates the buffers of the driver, see buffer_count_.
+        void AllocateBuffers(size_t size);
+
+        /// Stops the leases from giving buffers back to the driver, the
+        /// transfer must be freed after. Waits for a lease that is giving
+        /// its buffer back.
+        void RevokeLeases();
+
+        /// The buffers are only freed once the last lease is released.
+        void FreeBuffers();
+
         std::string GetModel() const;
 
         //==========================================================================
@@ -161,11 +205,52 @@ namespace provider_vision {
 
         mutable std::mutex cam_access_;
 
-        mutable std::mutex timer_access_;
-
         GEV_CAMERA_HANDLE gige_camera_;
 
-        atlas::MilliTimer acquisition_timer_;
+        /// The buffers the driver fills. The frames that point in one of them
+        /// share the ring, so the buffers outlive a Close until the last of
+        /// these frames is released.
+        struct BufferRing {
+            ~BufferRing();
+
+            GEV_CAMERA_HANDLE camera;
+            std::vector<PUINT8> buffers;
+
+            /// Cleared before the transfer is freed, the leases then have
+            /// nothing to give back to the driver. A lease checks it and
+            /// gives its buffer back under the lock, so the transfer is
+            /// never freed in between.
+            std::mutex access;
+            bool transferring;
+        };
+
+        /// Reallocated on every Open.
+        std::shared_ptr<BufferRing> ring_;
+
+        /// Whether the acquisition skips to the newest buffer ("latest" mode)
+        /// or reads them all in order ("every" mode).
+        bool keep_latest_;
+
+        /// Whether the frames point in the buffers of the driver, see
+        /// zero_copy_.
+        bool lease_buffers_;
+
+        /// Whether the conversion bins the quads of the mosaic.
+        bool binning_;
+
+        /// Steady clock time of the last frame, in nanoseconds, or 0 when not
+        /// streaming. The acquisition only stores it, so the watchdog never
+        /// blocks the capture and the capture never waits on a lock.
+        std::atomic<int64_t> last_frame_time_;
+
+        /// Maps the timestamps of the buffers to ROS time.
+        DeviceClock device_clock_;
+
+        /// Only accessed by NextFrame, and by SetStreamingModeOn before the
+        /// acquisition starts.
+        int64_t last_block_id_;
+
+        int64_t sequence_;
     };
 
 //==============================================================================
@@ -185,16 +270,37 @@ namespace provider_vision {
 //------------------------------------------------------------------------------
 //
     inline double GigeCamera::GetAcquistionTimerValue() const {
-        timer_access_.lock();
-        double timer = acquisition_timer_.Time();
-        timer_access_.unlock();
-        return timer;
+        const int64_t last_frame_time = last_frame_time_.load();
+        if (last_frame_time == 0) {
+            return 0.0;
+        }
+        const std::chrono::nanoseconds now =
+            std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>(
+            now - std::chrono::nanoseconds(last_frame_time)).count();
+    }
+
+//------------------------------------------------------------------------------
+//
+    inline void GigeCamera::FeedWatchdog() {
+        last_frame_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
 //------------------------------------------------------------------------------
 //
     inline GEV_CAMERA_HANDLE *GigeCamera::GetCameraPtr() { return &gige_camera_; }
 
+//------------------------------------------------------------------------------
+//
+    inline std::string GigeCamera::GetRawEncoding() const {
+        return sensor_msgs::image_encodings::BAYER_RGGB8;
+    }
+
+//------------------------------------------------------------------------------
+//
+    inline bool GigeCamera::CanFuseUndistortion() const { return !binning_; }
+
 }  // namespace provider_vision
 
 #endif  // PROVIDER_VISION_GIGE_CAMERA_H
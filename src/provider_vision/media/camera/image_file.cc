@@ -81,6 +81,13 @@ bool ImageFile::NextImage(cv::Mat &image) {
   return false;
 }
 
+//------------------------------------------------------------------------------
+//
+bool ImageFile::NextFrame(Frame &frame) {
+  frame.raw = image_;
+  return !image_.empty();
+}
+
 //------------------------------------------------------------------------------
 //
 void ImageFile::NextImageCopy(cv::Mat &image) { NextImage(image); }
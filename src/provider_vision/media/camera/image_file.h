@@ -79,6 +79,14 @@ class ImageFile : public BaseMedia {
    */
   void NextImageCopy(cv::Mat &image) override;
 
+  /**
+   * Method override from Media.
+   *
+   * The streamer never writes in the raw image of a frame, so the image is
+   * shared instead of being cloned for every frame.
+   */
+  bool NextFrame(Frame &frame) override;
+
  private:
   //==========================================================================
   // P R I V A T E   M E M B E R S
@@ -0,0 +1,303 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/camera/synthetic_media.h"
+#include <ros/ros.h>
+#include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <sstream>
+#include <string>
+#include "provider_vision/media/conversion/bayer_demosaic.h"
+#include "provider_vision/media/conversion/yuv422.h"
+
+namespace provider_vision {
+
+const char *SyntheticMedia::NAME_PREFIX = "synthetic";
+
+namespace {
+
+// How far the pattern scrolls before it starts over, in pixels. It is even,
+// so a view of a Bayer or YUV422 pattern keeps its phase.
+const int kTravel = 128;
+
+const int kStep = 2;
+
+// The eight color bars of the pattern, in BGR.
+const cv::Vec3b kBars[] = {
+    cv::Vec3b(255, 255, 255), cv::Vec3b(0, 255, 255), cv::Vec3b(255, 255, 0),
+    cv::Vec3b(0, 255, 0),     cv::Vec3b(255, 0, 255), cv::Vec3b(0, 0, 255),
+    cv::Vec3b(255, 0, 0),     cv::Vec3b(0, 0, 0)};
+
+uchar Clamp(int value) {
+  return static_cast<uchar>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+}  // namespace
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+SyntheticMedia::SyntheticMedia(const std::string &name)
+    : BaseMedia(name),
+      format_(Format::BAYER_RG8),
+      size_(2048, 1536),
+      frame_rate_(15.0),
+      moving_(false),
+      binning_(false),
+      pattern_(),
+      frame_count_(0) {
+  ParseName(name);
+}
+
+//------------------------------------------------------------------------------
+//
+SyntheticMedia::~SyntheticMedia() {}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::IsSyntheticName(const std::string &name) {
+  return name.compare(0, std::string(NAME_PREFIX).size(), NAME_PREFIX) == 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::Open() {
+  GeneratePattern();
+  int type = CV_8UC1;
+  if (format_ == Format::YUV422) {
+    type = CV_8UC2;
+  } else if (format_ == Format::BGR8) {
+    type = CV_8UC3;
+  }
+  raw_pool_.Reserve(size_.height, size_.width, type);
+  frame_count_ = 0;
+  ROS_INFO("%s generates %dx%d %s frames at %.1f fps%s",
+           media_name_.c_str(), size_.width, size_.height,
+           GetRawEncoding().empty() ? "bgr8" : GetRawEncoding().c_str(),
+           frame_rate_, moving_ ? ", moving" : "");
+  status_ = Status::OPEN;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::Close() {
+  pattern_.release();
+  status_ = Status::CLOSE;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::SetStreamingModeOn() {
+  status_ = Status::STREAMING;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::SetStreamingModeOff() {
+  status_ = Status::OPEN;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::NextImage(cv::Mat &image) {
+  Frame frame;
+  if (!NextFrame(frame) || !ConvertFrame(frame)) {
+    return false;
+  }
+  // The image may share the buffer of the pool, it is copied before the
+  // frame gives it back.
+  frame.image.copyTo(image);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::NextFrame(Frame &frame) {
+  if (pattern_.empty()) {
+    return false;
+  }
+
+  int offset = 0;
+  if (moving_) {
+    offset = static_cast<int>((frame_count_ * kStep) % kTravel);
+  }
+  frame.raw_message =
+      raw_pool_.Acquire(size_.height, size_.width, pattern_.type(), frame.raw);
+  pattern_(cv::Rect(offset, 0, size_.width, size_.height)).copyTo(frame.raw);
+  frame.info.sequence = frame_count_++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::ConvertFrame(Frame &frame) const {
+  try {
+    if (format_ == Format::BAYER_RG8) {
+      if (binning_) {
+        DemosaicBinning(frame.raw, BayerPattern::RGGB, frame.image);
+      } else {
+        DemosaicBilinear(frame.raw, BayerPattern::RGGB, frame.image);
+      }
+    } else if (format_ == Format::YUV422) {
+      ConvertUyvyToBgr(frame.raw, frame.image);
+    } else {
+      frame.image = frame.raw;
+    }
+  } catch (cv::Exception &e) {
+    ROS_ERROR("Error on opencv image transformation %s", e.what());
+    return false;
+  }
+  return !frame.image.empty();
+}
+
+//------------------------------------------------------------------------------
+//
+bool SyntheticMedia::ConvertUndistortedFrame(Frame &frame, const cv::Mat &map1,
+                                             const cv::Mat &map2) const {
+  try {
+    if (!DemosaicRemap(frame.raw, BayerPattern::RGGB, map1, map2,
+                       frame.image)) {
+      return false;
+    }
+  } catch (cv::Exception &e) {
+    ROS_ERROR("Error on opencv image transformation %s", e.what());
+    return false;
+  }
+  return !frame.image.empty();
+}
+
+//------------------------------------------------------------------------------
+//
+std::string SyntheticMedia::GetRawEncoding() const {
+  if (format_ == Format::BAYER_RG8) {
+    return sensor_msgs::image_encodings::BAYER_RGGB8;
+  } else if (format_ == Format::YUV422) {
+    return sensor_msgs::image_encodings::YUV422;
+  }
+  return "";
+}
+
+//------------------------------------------------------------------------------
+//
+void SyntheticMedia::ParseName(const std::string &name) {
+  std::stringstream ss(name);
+  std::string token;
+  // The prefix.
+  std::getline(ss, token, '_');
+
+  while (std::getline(ss, token, '_')) {
+    int width = 0, height = 0;
+    char *end = nullptr;
+    const double number = std::strtod(token.c_str(), &end);
+    if (token == "bayer") {
+      format_ = Format::BAYER_RG8;
+    } else if (token == "yuv422") {
+      format_ = Format::YUV422;
+    } else if (token == "bgr") {
+      format_ = Format::BGR8;
+    } else if (token == "moving") {
+      moving_ = true;
+    } else if (token == "binning") {
+      binning_ = true;
+    } else if (std::sscanf(token.c_str(), "%dx%d", &width, &height) == 2 &&
+               width > 0 && height > 0) {
+      // The Bayer and YUV422 patterns go by pairs of pixels.
+      size_ = cv::Size(width & ~1, height & ~1);
+    } else if (!token.empty() && *end == '\0' && number >= 0.0) {
+      frame_rate_ = number;
+    } else {
+      ROS_WARN("%s: unknown part of a synthetic media name: %s", name.c_str(),
+               token.c_str());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void SyntheticMedia::GeneratePattern() {
+  const int width = size_.width + (moving_ ? kTravel : 0);
+  const int bar_width = std::max(1, size_.width / 8);
+  cv::Mat bgr(size_.height, width, CV_8UC3);
+
+  // Color bars on the top two thirds, a gray ramp under them.
+  const int ramp_start = size_.height * 2 / 3;
+  for (int y = 0; y < bgr.rows; ++y) {
+    cv::Vec3b *row = bgr.ptr<cv::Vec3b>(y);
+    for (int x = 0; x < bgr.cols; ++x) {
+      if (y < ramp_start) {
+        row[x] = kBars[(x / bar_width) % 8];
+      } else {
+        const uchar gray = static_cast<uchar>((x * 255) / std::max(1, width - 1));
+        row[x] = cv::Vec3b(gray, gray, gray);
+      }
+    }
+  }
+
+  if (format_ == Format::BGR8) {
+    pattern_ = bgr;
+  } else if (format_ == Format::BAYER_RG8) {
+    // R G R G...
+    // G B G B...
+    pattern_.create(bgr.rows, bgr.cols, CV_8UC1);
+    for (int y = 0; y < bgr.rows; ++y) {
+      const cv::Vec3b *src = bgr.ptr<cv::Vec3b>(y);
+      uchar *dst = pattern_.ptr<uchar>(y);
+      for (int x = 0; x < bgr.cols; ++x) {
+        const int channel = (y % 2 == 0) ? (x % 2 == 0 ? 2 : 1)
+                                         : (x % 2 == 0 ? 1 : 0);
+        dst[x] = src[x][channel];
+      }
+    }
+  } else {
+    // U Y0 V Y1, BT.601 with the video range.
+    pattern_.create(bgr.rows, bgr.cols, CV_8UC2);
+    for (int y = 0; y < bgr.rows; ++y) {
+      const cv::Vec3b *src = bgr.ptr<cv::Vec3b>(y);
+      uchar *dst = pattern_.ptr<uchar>(y);
+      for (int x = 0; x + 1 < bgr.cols; x += 2) {
+        int luma[2], u = 0, v = 0;
+        for (int i = 0; i < 2; ++i) {
+          const int b = src[x + i][0], g = src[x + i][1], r = src[x + i][2];
+          luma[i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+          u += ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+          v += ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+        dst[2 * x] = Clamp(u / 2);
+        dst[2 * x + 1] = Clamp(luma[0]);
+        dst[2 * x + 2] = Clamp(v / 2);
+        dst[2 * x + 3] = Clamp(luma[1]);
+      }
+    }
+  }
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,158 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CAMERA_SYNTHETIC_MEDIA_H_
+#define PROVIDER_VISION_MEDIA_CAMERA_SYNTHETIC_MEDIA_H_
+
+#include <memory>
+#include <opencv2/core/core.hpp>
+#include <string>
+#include "provider_vision/config.h"
+#include "provider_vision/media/camera/base_media.h"
+
+namespace provider_vision {
+
+/**
+ * A media generating a test pattern in the native format of our cameras, to
+ * benchmark the acquisition, conversion and publishing without any hardware.
+ *
+ * Everything is described by the name of the media:
+ * synthetic_<format>_<width>x<height>_<fps>[_moving][_binning]
+ * where the format is bayer (BayerRG8, as the GigE cameras), yuv422 (as the
+ * DC1394 cameras) or bgr. Every part but the prefix is optional, the default
+ * is a 2048x1536 Bayer pattern at 15 fps, i.e. one of our GigE cameras.
+ * The streamer paces the frames at this rate, with a playback speed of 0
+ * (see CameraConfiguration) they are generated as fast as it takes them.
+ * With moving, the pattern scrolls by two pixels per frame. With binning, the
+ * Bayer pattern is converted at half resolution (see DemosaicBinning).
+ *
+ * The pattern is generated once, when the media is opened, the acquisition
+ * then costs a copy per frame, as it does with a camera.
+ */
+class SyntheticMedia : public BaseMedia {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<SyntheticMedia>;
+
+  enum class Format { BAYER_RG8, YUV422, BGR8 };
+
+  static const char *NAME_PREFIX;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit SyntheticMedia(const std::string &name);
+
+  virtual ~SyntheticMedia();
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Returns true if the name describes a synthetic media.
+   */
+  static bool IsSyntheticName(const std::string &name);
+
+  bool Open() override;
+
+  bool Close() override;
+
+  bool SetStreamingModeOn() override;
+
+  bool SetStreamingModeOff() override;
+
+  bool NextImage(cv::Mat &image) override;
+
+  /// Copies the next view of the pattern in the raw image of the frame.
+  bool NextFrame(Frame &frame) override;
+
+  /// Converts the raw image to BGR, as the camera of the same format does.
+  bool ConvertFrame(Frame &frame) const override;
+
+  /// As the Bayer cameras at full resolution.
+  bool CanFuseUndistortion() const override;
+
+  bool ConvertUndistortedFrame(Frame &frame, const cv::Mat &map1,
+                               const cv::Mat &map2) const override;
+
+  std::string GetRawEncoding() const override;
+
+  double GetFrameRate() const override;
+
+  Format GetFormat() const;
+
+  const cv::Size &GetSize() const;
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  void ParseName(const std::string &name);
+
+  // Draws the BGR pattern and stores it in the format of the media.
+  void GeneratePattern();
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  Format format_;
+
+  cv::Size size_;
+
+  double frame_rate_;
+
+  bool moving_;
+
+  bool binning_;
+
+  // Wider than a frame when the pattern moves, a frame is a view of it.
+  cv::Mat pattern_;
+
+  int64_t frame_count_;
+};
+
+//==============================================================================
+// I N L I N E   F U N C T I O N S   D E F I N I T I O N S
+
+//------------------------------------------------------------------------------
+//
+inline double SyntheticMedia::GetFrameRate() const { return frame_rate_; }
+
+//------------------------------------------------------------------------------
+//
+inline bool SyntheticMedia::CanFuseUndistortion() const {
+  return format_ == Format::BAYER_RG8 && !binning_;
+}
+
+//------------------------------------------------------------------------------
+//
+inline SyntheticMedia::Format SyntheticMedia::GetFormat() const {
+  return format_;
+}
+
+//------------------------------------------------------------------------------
+//
+inline const cv::Size &SyntheticMedia::GetSize() const { return size_; }
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CAMERA_SYNTHETIC_MEDIA_H_
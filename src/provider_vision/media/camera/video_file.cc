@@ -19,6 +19,7 @@
 /// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
 
 #include "provider_vision/media/camera/video_file.h"
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,8 @@ VideoFile::VideoFile(const std::string &path_to_file, bool looping)
     : BaseMedia(path_to_file),
       VideoCapture(path_to_file),
       current_image_(),
+      frame_size_(),
+      frame_rate_(0.0),
       path_(path_to_file),
       looping_(looping) {
   LoadVideo(path_);
@@ -63,6 +66,17 @@ bool VideoFile::Open() {
     return false;
   }
 
+  frame_size_ = cv::Size(static_cast<int>(get(CV_CAP_PROP_FRAME_WIDTH)),
+                         static_cast<int>(get(CV_CAP_PROP_FRAME_HEIGHT)));
+  // Some containers do not store it, the streamer then uses its own rate.
+  frame_rate_ = get(CV_CAP_PROP_FPS);
+  if (!std::isfinite(frame_rate_) || frame_rate_ < 0.0) {
+    frame_rate_ = 0.0;
+  }
+  if (frame_size_.area() > 0) {
+    raw_pool_.Reserve(frame_size_.height, frame_size_.width, CV_8UC3);
+  }
+
   status_ = Status::OPEN;
   return true;
 }
@@ -131,4 +145,40 @@ bool VideoFile::NextImage(cv::Mat &image) {
   return false;
 }
 
+//------------------------------------------------------------------------------
+//
+bool VideoFile::NextFrame(Frame &frame) {
+  if (frame_size_.area() <= 0) {
+    return BaseMedia::NextFrame(frame);
+  }
+  if (!isOpened()) {
+    return false;
+  }
+
+  // The decoder writes in the image it is given as long as it has the right
+  // geometry, so this is the only copy of the pixels.
+  frame.raw_message = raw_pool_.Acquire(frame_size_.height, frame_size_.width,
+                                        CV_8UC3, frame.raw);
+  const uchar *buffer = frame.raw.data;
+  if (read(frame.raw) && !frame.raw.empty()) {
+    if (frame.raw.data != buffer) {
+      // The video does not have the geometry it announced, the decoder
+      // allocated its own image.
+      frame.raw_message.reset();
+    }
+    return true;
+  }
+
+  frame.raw_message.reset();
+  frame.raw.release();
+  if (looping_) {
+    // end of sequence, going back to first frame.
+    set(CV_CAP_PROP_POS_AVI_RATIO, 0);
+  } else {
+    ROS_ERROR("No image could be acquiered from this media %s.",
+              path_.c_str());
+  }
+  return false;
+}
+
 }  // namespace provider_vision
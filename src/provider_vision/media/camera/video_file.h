@@ -61,6 +61,14 @@ class VideoFile : public BaseMedia, private cv::VideoCapture {
 
   bool NextImage(cv::Mat &image) override;
 
+  /**
+   * Decodes the next image straight in a buffer of the pool of the media,
+   * instead of a new image for every frame.
+   */
+  bool NextFrame(Frame &frame) override;
+
+  double GetFrameRate() const override;
+
   void SetPathToVideo(const std::string &full_path);
 
   void SetLooping(bool looping);
@@ -73,10 +81,24 @@ class VideoFile : public BaseMedia, private cv::VideoCapture {
 
   cv::Mat current_image_;
 
+  // The geometry of the video, known once it is opened.
+  cv::Size frame_size_;
+
+  // The frame rate stored in the video, known once it is opened.
+  double frame_rate_;
+
   std::string path_;
 
   bool looping_;
 };
+
+//==============================================================================
+// I N L I N E   F U N C T I O N S   D E F I N I T I O N S
+
+//------------------------------------------------------------------------------
+//
+inline double VideoFile::GetFrameRate() const { return frame_rate_; }
+
 }  // namespace provider_vision
 
 #endif  // PROVIDER_VISION_MEDIA_CAMERA_VIDEO_FILE_H_
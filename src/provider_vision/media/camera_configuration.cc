@@ -19,6 +19,7 @@
 /// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
 
 #include <provider_vision/media/camera_configuration.h>
+#include <ros/ros.h>
 #include <boost/lexical_cast.hpp>
 
 namespace provider_vision {
@@ -52,7 +53,42 @@ CameraConfiguration::CameraConfiguration(const ros::NodeHandle &nh,
       format_(17301513),
       auto_brightness_auto_(true),
       auto_brightness_target_(128),
-      auto_brightness_target_variation_(16) {
+      auto_brightness_target_variation_(16),
+      undistortion_matrice_path_(""),
+      undistortion_(false),
+      streamer_mode_("sequential"),
+      convert_queue_depth_(2),
+      convert_queue_policy_("drop"),
+      publish_queue_depth_(2),
+      publish_queue_policy_("drop"),
+      output_mode_("color"),
+      frame_pool_size_(8),
+      playback_frame_rate_(0.0),
+      playback_speed_(1.0),
+      frame_id_(name),
+      diagnostics_period_(1.0),
+      cpu_affinity_(""),
+      acquisition_cpu_affinity_(""),
+      realtime_priority_(0),
+      lock_memory_(false),
+      buffer_count_(4),
+      buffer_mode_("latest"),
+      zero_copy_(false),
+      conversion_("full"),
+      pyramid_levels_(0),
+      pyramid_filter_("gaussian"),
+      qos_priority_(0),
+      qos_target_fps_(0.0),
+      qos_min_fps_(1.0),
+      qos_max_latency_(0.0),
+      jpeg_output_(false),
+      jpeg_quality_(80),
+      jpeg_restart_rows_(4),
+      bayer_compression_("none"),
+      recording_directory_(""),
+      recording_codec_("avc1"),
+      recording_fps_(0.0),
+      recording_queue_depth_(4) {
   DeserializeConfiguration(name);
 }
 
@@ -95,6 +131,48 @@ void CameraConfiguration::DeserializeConfiguration(const std::string &name) {
   FindParameter(name + "_auto_brightness_target_variation",
                 auto_brightness_target_variation_);
   FindParameter(name + "_exposure_auto", exposure_auto_);
+  FindParameter(name + "_undistortion_matrice_path",
+                undistortion_matrice_path_);
+  FindParameter(name + "_undistortion", undistortion_);
+  FindParameter(name + "_streamer_mode", streamer_mode_);
+  FindParameter(name + "_convert_queue_depth", convert_queue_depth_);
+  FindParameter(name + "_convert_queue_policy", convert_queue_policy_);
+  FindParameter(name + "_publish_queue_depth", publish_queue_depth_);
+  FindParameter(name + "_publish_queue_policy", publish_queue_policy_);
+  FindParameter(name + "_output_mode", output_mode_);
+  FindParameter(name + "_frame_pool_size", frame_pool_size_);
+  if (frame_pool_size_ < 1) {
+    // The pools take it as a size_t, a negative size would be huge.
+    ROS_WARN("%s_frame_pool_size must be at least 1, not %d. 1 is used.",
+             name.c_str(), frame_pool_size_);
+    frame_pool_size_ = 1;
+  }
+  FindParameter(name + "_playback_frame_rate", playback_frame_rate_);
+  FindParameter(name + "_playback_speed", playback_speed_);
+  FindParameter(name + "_frame_id", frame_id_);
+  FindParameter(name + "_diagnostics_period", diagnostics_period_);
+  FindParameter(name + "_cpu_affinity", cpu_affinity_);
+  FindParameter(name + "_acquisition_cpu_affinity", acquisition_cpu_affinity_);
+  FindParameter(name + "_realtime_priority", realtime_priority_);
+  FindParameter(name + "_lock_memory", lock_memory_);
+  FindParameter(name + "_buffer_count", buffer_count_);
+  FindParameter(name + "_buffer_mode", buffer_mode_);
+  FindParameter(name + "_zero_copy", zero_copy_);
+  FindParameter(name + "_conversion", conversion_);
+  FindParameter(name + "_pyramid_levels", pyramid_levels_);
+  FindParameter(name + "_pyramid_filter", pyramid_filter_);
+  FindParameter(name + "_qos_priority", qos_priority_);
+  FindParameter(name + "_qos_target_fps", qos_target_fps_);
+  FindParameter(name + "_qos_min_fps", qos_min_fps_);
+  FindParameter(name + "_qos_max_latency", qos_max_latency_);
+  FindParameter(name + "_jpeg_output", jpeg_output_);
+  FindParameter(name + "_jpeg_quality", jpeg_quality_);
+  FindParameter(name + "_jpeg_restart_rows", jpeg_restart_rows_);
+  FindParameter(name + "_bayer_compression", bayer_compression_);
+  FindParameter(name + "_recording_directory", recording_directory_);
+  FindParameter(name + "_recording_codec", recording_codec_);
+  FindParameter(name + "_recording_fps", recording_fps_);
+  FindParameter(name + "_recording_queue_depth", recording_queue_depth_);
 }
 
 }  // namespace provider_vision
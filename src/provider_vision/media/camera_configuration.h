@@ -78,7 +78,126 @@ class CameraConfiguration : public atlas::ConfigurationParser {
   int auto_brightness_target_;
   int auto_brightness_target_variation_;
 
+  // The calibration of the camera (an OpenCV calibration file). With the
+  // undistortion enabled, the streamer undistorts the images before
+  // publishing them.
   std::string undistortion_matrice_path_;
+  bool undistortion_;
+
+  // MediaStreamer parameters. The mode is either "sequential" (acquisition,
+  // conversion and publishing on the same thread) or "pipelined" (one thread
+  // per stage). The policies are the one of SpscRing: "block", "drop" or
+  // "keep_latest".
+  std::string streamer_mode_;
+  int convert_queue_depth_;
+  std::string convert_queue_policy_;
+  int publish_queue_depth_;
+  std::string publish_queue_policy_;
+
+  // Either "color" (only the BGR image is published) or "raw" (the native
+  // buffer of the camera is published on the raw sub-topic as well).
+  // In both modes, the BGR image is only converted while someone subscribes
+  // to it.
+  std::string output_mode_;
+
+  // Number of preallocated buffers for the raw images of the media and for
+  // the converted images of the streamer. It must cover every frame in
+  // flight: the one acquired, the ones in the queues and the ones the
+  // subscribers still hold.
+  int frame_pool_size_;
+
+  // Playback of the medias without a frame rate of their own (images and
+  // videos). The frame rate replaces the native one of the media when it is
+  // positive, and the speed multiplies it. A speed of 0 plays the media as
+  // fast as possible.
+  double playback_frame_rate_;
+  double playback_speed_;
+
+  // The frame_id of the published images, the name of the configuration by
+  // default.
+  std::string frame_id_;
+
+  // Seconds between two diagnostics of the streamer, 0 disables them.
+  double diagnostics_period_;
+
+  // Scheduling of the threads of the streamer. The CPUs are a list ("2,4-5")
+  // or a mask ("0x34"), an empty string leaves the threads on any CPU. The
+  // acquisition CPUs apply to the acquisition thread only and default to
+  // the CPUs of the streamer. A real-time priority (1 to 99) schedules the
+  // acquisition thread with SCHED_FIFO, 0 leaves it to the default policy.
+  // Locking the memory applies to the whole process: the frame buffers,
+  // written once when they are allocated, then never fault.
+  std::string cpu_affinity_;
+  std::string acquisition_cpu_affinity_;
+  int realtime_priority_;
+  bool lock_memory_;
+
+  // Buffers of the driver of the cameras (the DMA ring of the DC1394
+  // cameras). In the "latest" mode, the acquisition always takes the newest
+  // buffer and gives the stale ones back to the driver. In the "every" mode,
+  // every frame is delivered in order and the camera only drops frames once
+  // all the buffers are full, so the count is the burst the acquisition can
+  // absorb when the consumers stall.
+  int buffer_count_;
+  std::string buffer_mode_;
+
+  // Hands the buffers of the driver down the pipeline instead of copying
+  // them. Only in the "every" buffer mode, where the driver does not
+  // overwrite a buffer before it is given back. The buffer count must then
+  // cover every frame in flight until its conversion.
+  bool zero_copy_;
+
+  // Conversion of the Bayer cameras: "full" (bilinear demosaicing, the image
+  // has the size of the sensor) or "binning" (every 2x2 quad of the mosaic is
+  // a pixel, the image is half the width and height of the sensor).
+  std::string conversion_;
+
+  // Levels of the image pyramid, each one half the size of the level above
+  // it, published on the sub-topics level1, level2, ... of the image. The
+  // filter is either "gaussian" (cv::pyrDown) or "box" (mean of every 2x2
+  // block). Only the levels down to the deepest one with a subscriber are
+  // computed.
+  int pyramid_levels_;
+  std::string pyramid_filter_;
+
+  // Quality of service of the stream when the CPU cannot keep up with all
+  // the cameras, see StreamScheduler. The frames are published at the
+  // target rate (0 publishes all of them) and must be within the latency
+  // from their capture (0 is the period of the target rate, no deadline
+  // without a target rate). When a stream misses its deadline, the streams
+  // of a lower priority skip frames, down to their minimal rate.
+  int qos_priority_;
+  double qos_target_fps_;
+  double qos_min_fps_;
+  double qos_max_latency_;
+
+  // JPEG compressed images published by the streamer on the compressed
+  // sub-topic, instead of the plugin of image_transport. They are encoded
+  // by the conversion stage, in parallel strips cut at the restart markers
+  // (a marker every restart_rows rows of blocks, 16 pixels high for the
+  // color images, 0 encodes on a single thread).
+  // The YUV422 images of the DC1394 cameras are encoded as they are, unless
+  // they are undistorted. The streamer is then always pipelined, so the
+  // acquisition never waits for the encoder.
+  bool jpeg_output_;
+  int jpeg_quality_;
+  int jpeg_restart_rows_;
+
+  // Compression of the raw Bayer mosaic of the GigE cameras, published on
+  // the bayer sub-topic: "none", "jpeg" (the planes of the four colors, with
+  // the JPEG quality and restart rows above) or "lossless". The consumers
+  // decode it with the conversion library, see bayer_codec.h.
+  std::string bayer_compression_;
+
+  // Recording of the image in a video of this directory, on a thread of its
+  // own (see MediaRecorder). Empty does not record. The codec is the FOURCC
+  // of the encoder, "avc1" is H.264. The rate stored in the video is the
+  // rate of the stream when 0. The images that do not fit in the queue of
+  // the encoder are not recorded.
+  std::string recording_directory_;
+  std::string recording_codec_;
+  double recording_fps_;
+  int recording_queue_depth_;
 
   //==========================================================================
   // P U B L I C   M E T H O D S
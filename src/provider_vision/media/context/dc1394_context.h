@@ -41,6 +41,7 @@ class DC1394Context : public BaseContext {
  public:
   const char *DRIVER_TAG;
 
+  // Seconds without a frame before a streaming camera is reported.
   const double TIME_FOR_BUS_ERROR = 3;
 
   //==========================================================================
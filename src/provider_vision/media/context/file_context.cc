@@ -57,6 +57,10 @@ bool FileContext::OpenMedia(const std::string &name) {
     } else if (type == MediaType::VIDEO) {
       VideoFile::Ptr file(std::make_shared<VideoFile>(name));
       media_list_.push_back(std::dynamic_pointer_cast<BaseMedia>(file));
+    } else if (type == MediaType::SYNTHETIC) {
+      SyntheticMedia::Ptr synthetic(std::make_shared<SyntheticMedia>(name));
+      synthetic->Open();
+      media_list_.push_back(std::dynamic_pointer_cast<BaseMedia>(synthetic));
     } else {
       ROS_ERROR("%s Not my media type", DRIVER_TAG);
       return false;
@@ -146,6 +150,10 @@ bool FileContext::WatchDogFunc() { return true; }
 //
 FileContext::MediaType FileContext::GetMediaType(
     const std::string &nameMedia) const {
+  if (SyntheticMedia::IsSyntheticName(nameMedia)) {
+    return MediaType::SYNTHETIC;
+  }
+
   // on commence par rechercher une image
   if (nameMedia.find(".jpg") != std::string::npos ||
       nameMedia.find(".png") != std::string::npos ||
@@ -26,6 +26,7 @@
 #include <vector>
 #include "provider_vision/config.h"
 #include "provider_vision/media/camera/image_file.h"
+#include "provider_vision/media/camera/synthetic_media.h"
 #include "provider_vision/media/camera/video_file.h"
 #include "provider_vision/media/context/base_context.h"
 
@@ -42,6 +43,8 @@ namespace provider_vision {
  * always available.
  * Therefore, calling GetCameraList() will return the list of videos from
  * _live_camera_list.
+ * The synthetic medias (see SyntheticMedia) are handled here as well, as the
+ * files, they exist as soon as they are asked for.
  */
 class FileContext : public BaseContext {
  public:
@@ -52,7 +55,7 @@ class FileContext : public BaseContext {
 
   using Ptr = std::shared_ptr<FileContext>;
 
-  enum class MediaType { IMAGE, VIDEO, NONE };
+  enum class MediaType { IMAGE, VIDEO, SYNTHETIC, NONE };
 
   //==========================================================================
   // P U B L I C   C / D T O R S
@@ -94,7 +97,7 @@ class FileContext : public BaseContext {
 
   /**
    * Return the type of a specific media passed in parameters.
-   * The parameter can be either en image or a video
+   * The parameter can be either en image, a video or a synthetic media.
    */
   virtual MediaType GetMediaType(const std::string &nameMedia) const;
 };
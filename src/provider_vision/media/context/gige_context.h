@@ -34,6 +34,7 @@ class GigeContext : public BaseContext {
  public:
   const char *DRIVER_TAG;
 
+  // Seconds without a frame before a streaming camera is reported.
   const double TIME_FOR_BUS_ERROR = 3;
   static const int MAX_CAMERAS = 4;
 
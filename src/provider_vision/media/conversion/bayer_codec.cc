@@ -0,0 +1,585 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/bayer_codec.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+#include <algorithm>
+#include "provider_vision/media/conversion/jpeg_encoder.h"
+#include "provider_vision/media/work_pool.h"
+
+namespace provider_vision {
+
+namespace {
+
+//==============================================================================
+// J P E G
+
+const char kJpegName[] = "bayer_jpeg";
+
+// The rows of a block of the JPEG, where the planes start.
+const int kBlockRows = 8;
+
+// The rows of the first three planes, padded to whole blocks: a block that
+// straddles two planes would blur their edges in one another.
+int GetPaddedPlaneRows(int plane_rows) {
+  return (plane_rows + kBlockRows - 1) / kBlockRows * kBlockRows;
+}
+
+// The planes of the colors of the mosaic, one below the other: the samples
+// of the even rows and columns first, then of the even rows and odd
+// columns, the odd rows and even columns, the odd rows and columns. The
+// first three planes are padded with their last row, the height of the
+// JPEG then tells the one of the mosaic (see GetPlaneRows).
+void SplitPlanes(const cv::Mat &bayer, cv::Mat &planes) {
+  const int width = bayer.cols / 2;
+  const int height = bayer.rows / 2;
+  const int padded = GetPaddedPlaneRows(height);
+  planes.create(3 * padded + height, width, CV_8UC1);
+  for (int y = 0; y < height; ++y) {
+    for (int dy = 0; dy < 2; ++dy) {
+      const uchar *src = bayer.ptr<uchar>(2 * y + dy);
+      uchar *even = planes.ptr<uchar>((2 * dy) * padded + y);
+      uchar *odd = planes.ptr<uchar>((2 * dy + 1) * padded + y);
+      for (int x = 0; x < width; ++x) {
+        even[x] = src[2 * x];
+        odd[x] = src[2 * x + 1];
+      }
+    }
+  }
+  for (int plane = 0; plane < 3; ++plane) {
+    const uchar *last = planes.ptr<uchar>(plane * padded + height - 1);
+    for (int y = height; y < padded; ++y) {
+      std::memcpy(planes.ptr<uchar>(plane * padded + y), last, width);
+    }
+  }
+}
+
+// The rows of a plane of the mosaic, from the rows of the JPEG. False if no
+// mosaic gives a JPEG of these rows.
+bool GetPlaneRows(int rows, int &plane_rows) {
+  const int padded = GetPaddedPlaneRows((rows + 3) / 4);
+  plane_rows = rows - 3 * padded;
+  return plane_rows > 0 && GetPaddedPlaneRows(plane_rows) == padded;
+}
+
+void MergePlanes(const cv::Mat &planes, int height, cv::Mat &bayer) {
+  const int width = planes.cols;
+  const int padded = GetPaddedPlaneRows(height);
+  bayer.create(2 * height, 2 * width, CV_8UC1);
+  for (int y = 0; y < height; ++y) {
+    for (int dy = 0; dy < 2; ++dy) {
+      uchar *dst = bayer.ptr<uchar>(2 * y + dy);
+      const uchar *even = planes.ptr<uchar>((2 * dy) * padded + y);
+      const uchar *odd = planes.ptr<uchar>((2 * dy + 1) * padded + y);
+      for (int x = 0; x < width; ++x) {
+        dst[2 * x] = even[x];
+        dst[2 * x + 1] = odd[x];
+      }
+    }
+  }
+}
+
+struct ErrorManager {
+  jpeg_error_mgr manager;
+  jmp_buf jump;
+};
+
+void JumpOnError(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<ErrorManager *>(cinfo->err)->jump, 1);
+}
+
+void IgnoreMessage(j_common_ptr cinfo) { (void)cinfo; }
+
+// The size of the grayscale JPEG, then its pixels once the image is
+// allocated. No object with a destructor may live here, libjpeg jumps out
+// on an error.
+bool DecodeGrayJpeg(const uint8_t *data, size_t size, cv::Mat &image) {
+  jpeg_decompress_struct cinfo;
+  ErrorManager error;
+  cinfo.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = JumpOnError;
+  error.manager.output_message = IgnoreMessage;
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, const_cast<unsigned char *>(data),
+               static_cast<unsigned long>(size));
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_GRAYSCALE;
+  jpeg_start_decompress(&cinfo);
+  image.create(static_cast<int>(cinfo.output_height),
+               static_cast<int>(cinfo.output_width), CV_8UC1);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = image.ptr<uchar>(static_cast<int>(cinfo.output_scanline));
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+//==============================================================================
+// L O S S L E S S
+
+const char kLosslessName[] = "bayer_lossless";
+
+// "PVBL", the version, then the width, the height and the rows per strip,
+// then the size of each strip.
+const uint8_t kLosslessMagic[5] = {'P', 'V', 'B', 'L', 1};
+const size_t kLosslessHeaderSize = 20;
+
+const int kStripRows = 64;
+
+// Samples coded with the same Rice parameter.
+const int kBlockSize = 32;
+
+// A quotient of 15 escapes the sample, written on 8 bits.
+const int kEscape = 15;
+
+void WriteUint32(uint32_t value, uint8_t *data) {
+  for (int i = 0; i < 4; ++i) {
+    data[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t ReadUint32(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Writes in a buffer large enough for the worst case, resized to the bits
+// written once flushed.
+class BitWriter {
+ public:
+  BitWriter(std::vector<uint8_t> &data, size_t capacity)
+      : data_(data), position_(0), bits_(0), count_(0) {
+    data_.resize(capacity);
+  }
+
+  // At most 32 bits at once, the bits are stored 32 at a time.
+  void Write(uint32_t value, int count) {
+    bits_ = (bits_ << count) | value;
+    count_ += count;
+    if (count_ >= 32) {
+      count_ -= 32;
+      const uint32_t word = static_cast<uint32_t>(bits_ >> count_);
+      uint8_t *out = &data_[position_];
+      out[0] = static_cast<uint8_t>(word >> 24);
+      out[1] = static_cast<uint8_t>(word >> 16);
+      out[2] = static_cast<uint8_t>(word >> 8);
+      out[3] = static_cast<uint8_t>(word);
+      position_ += 4;
+    }
+  }
+
+  void Flush() {
+    while (count_ >= 8) {
+      count_ -= 8;
+      data_[position_++] = static_cast<uint8_t>(bits_ >> count_);
+    }
+    if (count_ > 0) {
+      data_[position_++] = static_cast<uint8_t>(bits_ << (8 - count_));
+      count_ = 0;
+    }
+    data_.resize(position_);
+  }
+
+ private:
+  std::vector<uint8_t> &data_;
+  size_t position_;
+  uint64_t bits_;
+  int count_;
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t *data, size_t size)
+      : data_(data), end_(data + size), bits_(0), count_(0), padding_(0) {}
+
+  // At most 25 bits at once.
+  uint32_t Read(int count) {
+    Refill();
+    const uint32_t value = static_cast<uint32_t>(bits_ >> 32) >> (32 - count);
+    bits_ <<= count;
+    count_ -= count;
+    return value;
+  }
+
+  // The next sample coded with the parameter k.
+  uint32_t ReadSample(int k) {
+    Refill();
+    // The last bit is cleared, the count of ones stops there at worst.
+    const uint32_t window = static_cast<uint32_t>(bits_ >> 32);
+    const int ones = std::min(__builtin_clz(~(window & ~1u)), kEscape);
+    if (ones == kEscape) {
+      bits_ <<= kEscape + 8;
+      count_ -= kEscape + 8;
+      return (window >> (32 - kEscape - 8)) & 0xFF;
+    }
+    // The quotient in unary, a zero, then the remainder.
+    const int length = ones + 1 + k;
+    const uint32_t remainder =
+        k > 0 ? (window << (ones + 1)) >> (32 - k) : 0;
+    bits_ <<= length;
+    count_ -= length;
+    return (static_cast<uint32_t>(ones) << k) | remainder;
+  }
+
+  // False if more bits were read than there are.
+  bool IsValid() const { return count_ >= 8 * padding_; }
+
+ private:
+  // At least 32 bits in the buffer.
+  void Refill() {
+    if (count_ >= 32) {
+      return;
+    }
+    if (end_ - data_ >= 4) {
+      const uint64_t word = (static_cast<uint32_t>(data_[0]) << 24) |
+                            (static_cast<uint32_t>(data_[1]) << 16) |
+                            (static_cast<uint32_t>(data_[2]) << 8) |
+                            static_cast<uint32_t>(data_[3]);
+      bits_ |= word << (32 - count_);
+      count_ += 32;
+      data_ += 4;
+      return;
+    }
+    while (count_ <= 56) {
+      uint64_t byte = 0;
+      if (data_ < end_) {
+        byte = *data_++;
+      } else {
+        ++padding_;
+      }
+      bits_ |= byte << (56 - count_);
+      count_ += 8;
+    }
+  }
+
+  const uint8_t *data_;
+  const uint8_t *end_;
+  uint64_t bits_;
+  int count_;
+  int padding_;
+};
+
+// The median predictor of LOCO-I, from the sample of the same color to the
+// left (a), above (b) and above to the left (c). It is the median of a, b
+// and a + b - c, without a branch: the noise of the sensor would defeat the
+// branch predictor.
+inline int PredictMedian(int a, int b, int c) {
+  return std::max(std::min(a, b), std::min(std::max(a, b), a + b - c));
+}
+
+// The samples are predicted from their neighbors of the same color: two
+// columns to the left and two rows above. The first two rows of a strip are
+// only predicted from the left, so the strips are independent.
+inline int Predict(const uchar *row, const uchar *above, int x) {
+  if (!above) {
+    return x >= 2 ? row[x - 2] : 0;
+  }
+  if (x < 2) {
+    return above[x];
+  }
+  return PredictMedian(row[x - 2], above[x], above[x - 2]);
+}
+
+// The residuals modulo 256, folded on the positive numbers: 0, -1, 1, -2...
+inline uint8_t Fold(int residual) {
+  const int r = static_cast<int8_t>(residual);
+  return static_cast<uint8_t>((static_cast<unsigned>(r) << 1) ^
+                              static_cast<unsigned>(r >> 7));
+}
+
+inline int Unfold(uint32_t value) {
+  return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+void EncodeStrip(const cv::Mat &bayer, int first, int last,
+                 std::vector<uint8_t> &data) {
+  // At worst, 3 bits per block and an escaped sample of 23 bits.
+  const size_t samples = static_cast<size_t>(last - first) * bayer.cols;
+  BitWriter writer(data, samples * 3 + samples / kBlockSize + 8);
+  std::vector<uint8_t> folded(static_cast<size_t>(bayer.cols));
+  for (int y = first; y < last; ++y) {
+    const uchar *row = bayer.ptr<uchar>(y);
+    const uchar *above = y - first >= 2 ? bayer.ptr<uchar>(y - 2) : nullptr;
+    for (int x = 0; x < 2; ++x) {
+      folded[x] = Fold(row[x] - Predict(row, above, x));
+    }
+    if (above) {
+      for (int x = 2; x < bayer.cols; ++x) {
+        folded[x] = Fold(row[x] - PredictMedian(row[x - 2], above[x],
+                                                above[x - 2]));
+      }
+    } else {
+      for (int x = 2; x < bayer.cols; ++x) {
+        folded[x] = Fold(row[x] - row[x - 2]);
+      }
+    }
+
+    for (int start = 0; start < bayer.cols; start += kBlockSize) {
+      const int end = std::min(start + kBlockSize, bayer.cols);
+      uint32_t sum = 0;
+      for (int x = start; x < end; ++x) {
+        sum += folded[x];
+      }
+      // The parameter for which the mean of the block is the unit of the
+      // quotients.
+      const uint32_t count = static_cast<uint32_t>(end - start);
+      int k = 0;
+      while (k < 7 && (count << (k + 1)) <= sum) {
+        ++k;
+      }
+      writer.Write(static_cast<uint32_t>(k), 3);
+      for (int x = start; x < end; ++x) {
+        const uint32_t quotient = static_cast<uint32_t>(folded[x]) >> k;
+        if (quotient < static_cast<uint32_t>(kEscape)) {
+          // The quotient in unary, a zero, then the remainder.
+          writer.Write((((1u << quotient) - 1) << (k + 1)) |
+                           (folded[x] & ((1u << k) - 1)),
+                       static_cast<int>(quotient) + 1 + k);
+        } else {
+          writer.Write((((1u << kEscape) - 1) << 8) | folded[x], kEscape + 8);
+        }
+      }
+    }
+  }
+  writer.Flush();
+}
+
+bool DecodeStrip(const uint8_t *data, size_t size, int first, int last,
+                 cv::Mat &bayer) {
+  BitReader reader(data, size);
+  for (int y = first; y < last; ++y) {
+    uchar *row = bayer.ptr<uchar>(y);
+    const uchar *above = y - first >= 2 ? bayer.ptr<uchar>(y - 2) : nullptr;
+    for (int start = 0; start < bayer.cols; start += kBlockSize) {
+      const int end = std::min(start + kBlockSize, bayer.cols);
+      const int k = static_cast<int>(reader.Read(3));
+      int x = start;
+      for (; x < end && x < 2; ++x) {
+        row[x] = static_cast<uchar>(Predict(row, above, x) +
+                                    Unfold(reader.ReadSample(k)));
+      }
+      if (above) {
+        for (; x < end; ++x) {
+          row[x] = static_cast<uchar>(
+              PredictMedian(row[x - 2], above[x], above[x - 2]) +
+              Unfold(reader.ReadSample(k)));
+        }
+      } else {
+        for (; x < end; ++x) {
+          row[x] = static_cast<uchar>(row[x - 2] +
+                                      Unfold(reader.ReadSample(k)));
+        }
+      }
+    }
+  }
+  return reader.IsValid();
+}
+
+class EncodeBody : public cv::ParallelLoopBody {
+ public:
+  EncodeBody(const cv::Mat &bayer, std::vector<std::vector<uint8_t>> &strips)
+      : bayer_(bayer), strips_(strips) {}
+
+  void operator()(const cv::Range &range) const override {
+    for (int i = range.start; i < range.end; ++i) {
+      EncodeStrip(bayer_, i * kStripRows,
+                  std::min((i + 1) * kStripRows, bayer_.rows), strips_[i]);
+    }
+  }
+
+ private:
+  const cv::Mat &bayer_;
+  std::vector<std::vector<uint8_t>> &strips_;
+};
+
+class DecodeBody : public cv::ParallelLoopBody {
+ public:
+  DecodeBody(const std::vector<const uint8_t *> &strips,
+             const std::vector<size_t> &sizes, int strip_rows, cv::Mat &bayer,
+             std::vector<char> &decoded)
+      : strips_(strips),
+        sizes_(sizes),
+        strip_rows_(strip_rows),
+        bayer_(bayer),
+        decoded_(decoded) {}
+
+  void operator()(const cv::Range &range) const override {
+    for (int i = range.start; i < range.end; ++i) {
+      decoded_[i] = DecodeStrip(strips_[i], sizes_[i], i * strip_rows_,
+                                std::min((i + 1) * strip_rows_, bayer_.rows),
+                                bayer_);
+    }
+  }
+
+ private:
+  const std::vector<const uint8_t *> &strips_;
+  const std::vector<size_t> &sizes_;
+  int strip_rows_;
+  cv::Mat &bayer_;
+  std::vector<char> &decoded_;
+};
+
+bool EncodeLossless(const cv::Mat &bayer, std::vector<uint8_t> &data) {
+  const int strip_count = (bayer.rows + kStripRows - 1) / kStripRows;
+  std::vector<std::vector<uint8_t>> strips(strip_count);
+  WorkPool::Instance().ParallelFor(cv::Range(0, strip_count),
+                                   EncodeBody(bayer, strips), 1);
+
+  size_t size = kLosslessHeaderSize + 4 * strips.size();
+  for (const auto &strip : strips) {
+    size += strip.size();
+  }
+  data.resize(size);
+  std::copy(kLosslessMagic, kLosslessMagic + 5, data.begin());
+  std::fill(data.begin() + 5, data.begin() + 8, 0);
+  WriteUint32(static_cast<uint32_t>(bayer.cols), &data[8]);
+  WriteUint32(static_cast<uint32_t>(bayer.rows), &data[12]);
+  WriteUint32(static_cast<uint32_t>(kStripRows), &data[16]);
+  size_t position = kLosslessHeaderSize;
+  for (const auto &strip : strips) {
+    WriteUint32(static_cast<uint32_t>(strip.size()), &data[position]);
+    position += 4;
+  }
+  for (const auto &strip : strips) {
+    std::copy(strip.begin(), strip.end(), data.begin() + position);
+    position += strip.size();
+  }
+  return true;
+}
+
+bool DecodeLossless(const uint8_t *data, size_t size, cv::Mat &bayer) {
+  if (size < kLosslessHeaderSize ||
+      !std::equal(kLosslessMagic, kLosslessMagic + 5, data)) {
+    return false;
+  }
+  const uint32_t width = ReadUint32(data + 8);
+  const uint32_t height = ReadUint32(data + 12);
+  const uint32_t strip_rows = ReadUint32(data + 16);
+  if (width == 0 || height == 0 || width % 2 != 0 || height % 2 != 0 ||
+      width > 1u << 14 || height > 1u << 14 || strip_rows < 2) {
+    return false;
+  }
+  const size_t strip_count = (height + strip_rows - 1) / strip_rows;
+  size_t position = kLosslessHeaderSize + 4 * strip_count;
+  if (position > size) {
+    return false;
+  }
+  std::vector<const uint8_t *> strips(strip_count);
+  std::vector<size_t> sizes(strip_count);
+  for (size_t i = 0; i < strip_count; ++i) {
+    sizes[i] = ReadUint32(data + kLosslessHeaderSize + 4 * i);
+    if (sizes[i] > size - position) {
+      return false;
+    }
+    strips[i] = data + position;
+    position += sizes[i];
+  }
+
+  bayer.create(static_cast<int>(height), static_cast<int>(width), CV_8UC1);
+  std::vector<char> decoded(strip_count, 0);
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, static_cast<int>(strip_count)),
+      DecodeBody(strips, sizes, static_cast<int>(strip_rows), bayer, decoded),
+      1);
+  return std::find(decoded.begin(), decoded.end(), 0) == decoded.end();
+}
+
+}  // namespace
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+bool EncodeBayer(const cv::Mat &bayer, BayerCodec codec, int quality,
+                 int restart_rows, std::vector<uint8_t> &data) {
+  if (bayer.type() != CV_8UC1 || bayer.empty() || bayer.cols % 2 != 0 ||
+      bayer.rows % 2 != 0) {
+    return false;
+  }
+  if (codec == BayerCodec::LOSSLESS) {
+    return EncodeLossless(bayer, data);
+  }
+  // Kept from a frame to the next, the planes have about the size of the
+  // mosaic.
+  thread_local cv::Mat planes;
+  SplitPlanes(bayer, planes);
+  return EncodeJpeg(planes, quality, restart_rows, data);
+}
+
+//------------------------------------------------------------------------------
+//
+bool DecodeBayer(const uint8_t *data, size_t size, BayerCodec codec,
+                 cv::Mat &bayer) {
+  if (!data || size == 0) {
+    return false;
+  }
+  if (codec == BayerCodec::LOSSLESS) {
+    return DecodeLossless(data, size, bayer);
+  }
+  thread_local cv::Mat planes;
+  int height = 0;
+  if (!DecodeGrayJpeg(data, size, planes) ||
+      !GetPlaneRows(planes.rows, height)) {
+    return false;
+  }
+  MergePlanes(planes, height, bayer);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+std::string GetBayerFormat(const std::string &encoding, BayerCodec codec) {
+  return encoding + "; " +
+         (codec == BayerCodec::JPEG ? kJpegName : kLosslessName);
+}
+
+//------------------------------------------------------------------------------
+//
+bool ParseBayerFormat(const std::string &format, std::string &encoding,
+                      BayerCodec &codec) {
+  const size_t separator = format.find("; ");
+  if (separator == std::string::npos ||
+      format.compare(0, 6, "bayer_") != 0) {
+    return false;
+  }
+  const std::string name = format.substr(separator + 2);
+  if (name == kJpegName) {
+    codec = BayerCodec::JPEG;
+  } else if (name == kLosslessName) {
+    codec = BayerCodec::LOSSLESS;
+  } else {
+    return false;
+  }
+  encoding = format.substr(0, separator);
+  return true;
+}
+
+}  // namespace provider_vision
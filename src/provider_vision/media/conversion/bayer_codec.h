@@ -0,0 +1,86 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_BAYER_CODEC_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_BAYER_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include <string>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * Compression of the raw Bayer mosaic of the cameras, smaller than the one
+ * of the demosaiced image: a third of the samples, none of them
+ * interpolated.
+ *
+ *  - JPEG: the four colors of the mosaic are split in planes a quarter of
+ *    its size, stacked in a single grayscale JPEG (see EncodeJpeg) and
+ *    padded to its blocks of 8 rows. Each plane is a smooth image, unlike
+ *    the mosaic.
+ *  - LOSSLESS: every sample is predicted from its neighbors of the same
+ *    color (the median predictor of LOCO-I) and the residuals are coded
+ *    with Rice codes, adapted every 32 samples. The mosaic is cut in strips
+ *    of rows coded independently, in parallel on the WorkPool.
+ *
+ * The messages are sensor_msgs/CompressedImage with the format given by
+ * GetBayerFormat, the encoding of the mosaic followed by the codec. This
+ * library does not depend on ROS, a consumer decodes the message with
+ * ParseBayerFormat and DecodeBayer then demosaics it on its side (see
+ * DemosaicBilinear).
+ */
+enum class BayerCodec { JPEG, LOSSLESS };
+
+/**
+ * Compresses a CV_8UC1 mosaic of an even size. The quality and the restart
+ * rows only apply to the JPEG codec.
+ *
+ * \return False if the mosaic is not valid or could not be encoded.
+ */
+bool EncodeBayer(const cv::Mat &bayer, BayerCodec codec, int quality,
+                 int restart_rows, std::vector<uint8_t> &data);
+
+/**
+ * Decompresses the data in the mosaic, reallocated if it does not have its
+ * size.
+ *
+ * \return False if the data is not a valid mosaic of this codec.
+ */
+bool DecodeBayer(const uint8_t *data, size_t size, BayerCodec codec,
+                 cv::Mat &bayer);
+
+/**
+ * "bayer_rggb8; bayer_jpeg" or "bayer_rggb8; bayer_lossless", for the
+ * given encoding of the mosaic.
+ */
+std::string GetBayerFormat(const std::string &encoding, BayerCodec codec);
+
+/**
+ * \return False if the format is not the one of a compressed mosaic.
+ */
+bool ParseBayerFormat(const std::string &format, std::string &encoding,
+                      BayerCodec &codec);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_BAYER_CODEC_H_
@@ -0,0 +1,644 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/bayer_demosaic.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "provider_vision/media/work_pool.h"
+
+namespace provider_vision {
+
+namespace {
+
+// The channels of a BGR pixel, the other chroma of a channel c is 2 - c.
+const int kBlue = 0;
+const int kGreen = 1;
+const int kRed = 2;
+
+// A row of the mosaic alternates green with one chroma, the chroma sites are
+// either on the even or on the odd columns.
+struct RowLayout {
+  int chroma;
+  bool chroma_on_even;
+};
+
+RowLayout GetRowLayout(BayerPattern pattern, int y) {
+  RowLayout layout;
+  switch (pattern) {
+    case BayerPattern::GRBG:
+      layout = {kRed, false};
+      break;
+    case BayerPattern::GBRG:
+      layout = {kBlue, false};
+      break;
+    case BayerPattern::BGGR:
+      layout = {kBlue, true};
+      break;
+    default:
+      layout = {kRed, true};
+      break;
+  }
+  // The odd rows have the other chroma, on the other columns.
+  if (y % 2 != 0) {
+    layout.chroma = 2 - layout.chroma;
+    layout.chroma_on_even = !layout.chroma_on_even;
+  }
+  return layout;
+}
+
+// Interpolates the pixels [begin, end) of a row, the reference of the
+// vectorized kernels. The mosaic is mirrored past the borders (the pixel at
+// -1 is the one at 1), which keeps the colors of the neighbors.
+void DemosaicRowScalar(const uchar *up, const uchar *row, const uchar *down,
+                       int width, int begin, int end, RowLayout layout,
+                       uchar *bgr) {
+  const int chroma = layout.chroma;
+  const int other = 2 - chroma;
+  for (int x = begin; x < end; ++x) {
+    const int left = x > 0 ? x - 1 : 1;
+    const int right = x < width - 1 ? x + 1 : width - 2;
+    const int h = row[left] + row[right];
+    const int v = up[x] + down[x];
+    uchar *pixel = bgr + 3 * x;
+    if ((x % 2 == 0) == layout.chroma_on_even) {
+      pixel[chroma] = row[x];
+      pixel[kGreen] = static_cast<uchar>((h + v + 2) >> 2);
+      pixel[other] = static_cast<uchar>(
+          (up[left] + up[right] + down[left] + down[right] + 2) >> 2);
+    } else {
+      pixel[chroma] = static_cast<uchar>((h + 1) >> 1);
+      pixel[kGreen] = row[x];
+      pixel[other] = static_cast<uchar>((v + 1) >> 1);
+    }
+  }
+}
+
+#ifdef PROVIDER_VISION_X86
+
+// The vectorized kernels compute, for every pixel, the same candidates as
+// DemosaicRowScalar in 16 bits lanes and select them with a mask of the
+// chroma sites: the pixel itself, the mean of its horizontal, vertical,
+// horizontal and vertical, or diagonal neighbors. They start on an even
+// column so the mask is the same for every block, and leave the borders to
+// the scalar kernel.
+
+PROVIDER_VISION_TARGET_SSE41 inline __m128i Load8(const uchar *p) {
+  return _mm_cvtepu8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+}
+
+// Interpolates 8 pixels in the site chroma, green and other chroma.
+PROVIDER_VISION_TARGET_SSE41 inline void Interpolate8(
+    const uchar *up, const uchar *row, const uchar *down, __m128i site,
+    __m128i &s, __m128i &g, __m128i &o) {
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i two = _mm_set1_epi16(2);
+  const __m128i c = Load8(row);
+  const __m128i h = _mm_add_epi16(Load8(row - 1), Load8(row + 1));
+  const __m128i v = _mm_add_epi16(Load8(up), Load8(down));
+  const __m128i d =
+      _mm_add_epi16(_mm_add_epi16(Load8(up - 1), Load8(up + 1)),
+                    _mm_add_epi16(Load8(down - 1), Load8(down + 1)));
+  const __m128i h2 = _mm_srli_epi16(_mm_add_epi16(h, one), 1);
+  const __m128i v2 = _mm_srli_epi16(_mm_add_epi16(v, one), 1);
+  const __m128i x4 =
+      _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(h, v), two), 2);
+  const __m128i d4 = _mm_srli_epi16(_mm_add_epi16(d, two), 2);
+  s = _mm_blendv_epi8(h2, c, site);
+  g = _mm_blendv_epi8(c, x4, site);
+  o = _mm_blendv_epi8(v2, d4, site);
+}
+
+// Returns the first column it did not interpolate.
+PROVIDER_VISION_TARGET_SSE41 int DemosaicRowSse41(const uchar *up,
+                                                  const uchar *row,
+                                                  const uchar *down, int width,
+                                                  RowLayout layout,
+                                                  uchar *bgr) {
+  // The lanes of the chroma sites, 0xFFFF on the even or the odd lanes.
+  const __m128i site = layout.chroma_on_even ? _mm_set1_epi32(0x0000FFFF)
+                                             : _mm_set1_epi32(0xFFFF0000);
+  int x = 2;
+  for (; x + 16 < width; x += 16) {
+    __m128i s0, g0, o0, s1, g1, o1;
+    Interpolate8(up + x, row + x, down + x, site, s0, g0, o0);
+    Interpolate8(up + x + 8, row + x + 8, down + x + 8, site, s1, g1, o1);
+    const __m128i s = _mm_packus_epi16(s0, s1);
+    const __m128i g = _mm_packus_epi16(g0, g1);
+    const __m128i o = _mm_packus_epi16(o0, o1);
+    if (layout.chroma == kBlue) {
+      StoreBgr(bgr + 3 * x, s, g, o);
+    } else {
+      StoreBgr(bgr + 3 * x, o, g, s);
+    }
+  }
+  return x;
+}
+
+PROVIDER_VISION_TARGET_AVX2 inline __m256i Load16(const uchar *p) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+// Interpolates 16 pixels in the site chroma, green and other chroma.
+PROVIDER_VISION_TARGET_AVX2 inline void Interpolate16(
+    const uchar *up, const uchar *row, const uchar *down, __m256i site,
+    __m256i &s, __m256i &g, __m256i &o) {
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i two = _mm256_set1_epi16(2);
+  const __m256i c = Load16(row);
+  const __m256i h = _mm256_add_epi16(Load16(row - 1), Load16(row + 1));
+  const __m256i v = _mm256_add_epi16(Load16(up), Load16(down));
+  const __m256i d =
+      _mm256_add_epi16(_mm256_add_epi16(Load16(up - 1), Load16(up + 1)),
+                       _mm256_add_epi16(Load16(down - 1), Load16(down + 1)));
+  const __m256i h2 = _mm256_srli_epi16(_mm256_add_epi16(h, one), 1);
+  const __m256i v2 = _mm256_srli_epi16(_mm256_add_epi16(v, one), 1);
+  const __m256i x4 =
+      _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(h, v), two), 2);
+  const __m256i d4 = _mm256_srli_epi16(_mm256_add_epi16(d, two), 2);
+  s = _mm256_blendv_epi8(h2, c, site);
+  g = _mm256_blendv_epi8(c, x4, site);
+  o = _mm256_blendv_epi8(v2, d4, site);
+}
+
+// Packs two vectors of 16 bits lanes in 32 bytes, in order.
+PROVIDER_VISION_TARGET_AVX2 inline __m256i Pack16(__m256i a, __m256i b) {
+  // The pack works within the 128 bits lanes, the 64 bits quarters are
+  // reordered after.
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+PROVIDER_VISION_TARGET_AVX2 int DemosaicRowAvx2(const uchar *up,
+                                                const uchar *row,
+                                                const uchar *down, int width,
+                                                RowLayout layout, uchar *bgr) {
+  const __m256i site = layout.chroma_on_even ? _mm256_set1_epi32(0x0000FFFF)
+                                             : _mm256_set1_epi32(0xFFFF0000);
+  int x = 2;
+  for (; x + 32 < width; x += 32) {
+    __m256i s0, g0, o0, s1, g1, o1;
+    Interpolate16(up + x, row + x, down + x, site, s0, g0, o0);
+    Interpolate16(up + x + 16, row + x + 16, down + x + 16, site, s1, g1, o1);
+    const __m256i s = Pack16(s0, s1);
+    const __m256i g = Pack16(g0, g1);
+    const __m256i o = Pack16(o0, o1);
+    const __m256i b = layout.chroma == kBlue ? s : o;
+    const __m256i r = layout.chroma == kBlue ? o : s;
+    StoreBgr(bgr + 3 * x, _mm256_castsi256_si128(b),
+             _mm256_castsi256_si128(g), _mm256_castsi256_si128(r));
+    StoreBgr(bgr + 3 * (x + 16), _mm256_extracti128_si256(b, 1),
+             _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(r, 1));
+  }
+  return x;
+}
+
+#endif  // PROVIDER_VISION_X86
+
+// The positions of the colors in a quad: the pixel of the first row, of the
+// second row, and the two greens on their diagonal. Indexed as a, b, c, d:
+// the first row is a b and the second c d.
+struct QuadLayout {
+  int red;
+  int blue;
+  // Whether the greens are b and c (a and d otherwise).
+  bool green_on_bc;
+};
+
+QuadLayout GetQuadLayout(BayerPattern pattern) {
+  switch (pattern) {
+    case BayerPattern::GRBG:
+      return {1, 2, false};
+    case BayerPattern::GBRG:
+      return {2, 1, false};
+    case BayerPattern::BGGR:
+      return {3, 0, true};
+    default:
+      return {0, 3, true};
+  }
+}
+
+// Bins the quads [begin, end) of a pair of rows.
+void BinRowScalar(const uchar *first, const uchar *second, int begin, int end,
+                  QuadLayout layout, uchar *bgr) {
+  for (int x = begin; x < end; ++x) {
+    const uchar quad[4] = {first[2 * x], first[2 * x + 1], second[2 * x],
+                           second[2 * x + 1]};
+    const int green = layout.green_on_bc ? quad[1] + quad[2] : quad[0] + quad[3];
+    uchar *pixel = bgr + 3 * x;
+    pixel[kBlue] = quad[layout.blue];
+    pixel[kGreen] = static_cast<uchar>((green + 1) >> 1);
+    pixel[kRed] = quad[layout.red];
+  }
+}
+
+#ifdef PROVIDER_VISION_X86
+
+// Returns the first quad it did not bin.
+PROVIDER_VISION_TARGET_SSE41 int BinRowSse41(const uchar *first,
+                                             const uchar *second, int width,
+                                             QuadLayout layout, uchar *bgr) {
+  const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    // Splits 32 pixels of each row in their even and odd columns.
+    const __m128i *f = reinterpret_cast<const __m128i *>(first + 2 * x);
+    const __m128i *s = reinterpret_cast<const __m128i *>(second + 2 * x);
+    const __m128i f0 = _mm_loadu_si128(f);
+    const __m128i f1 = _mm_loadu_si128(f + 1);
+    const __m128i s0 = _mm_loadu_si128(s);
+    const __m128i s1 = _mm_loadu_si128(s + 1);
+    const __m128i quad[4] = {
+        _mm_packus_epi16(_mm_and_si128(f0, low_bytes),
+                         _mm_and_si128(f1, low_bytes)),
+        _mm_packus_epi16(_mm_srli_epi16(f0, 8), _mm_srli_epi16(f1, 8)),
+        _mm_packus_epi16(_mm_and_si128(s0, low_bytes),
+                         _mm_and_si128(s1, low_bytes)),
+        _mm_packus_epi16(_mm_srli_epi16(s0, 8), _mm_srli_epi16(s1, 8))};
+    // The average of pavgb is rounded up, as the scalar one.
+    const __m128i green = layout.green_on_bc
+                              ? _mm_avg_epu8(quad[1], quad[2])
+                              : _mm_avg_epu8(quad[0], quad[3]);
+    StoreBgr(bgr + 3 * x, quad[layout.blue], green, quad[layout.red]);
+  }
+  return x;
+}
+
+#endif  // PROVIDER_VISION_X86
+
+class BinningBody : public cv::ParallelLoopBody {
+ public:
+  BinningBody(const cv::Mat &bayer, BayerPattern pattern, cv::Mat &bgr,
+              SimdLevel level)
+      : bayer_(bayer), layout_(GetQuadLayout(pattern)), bgr_(bgr),
+        level_(level) {}
+
+  void operator()(const cv::Range &range) const override {
+    const int width = bgr_.cols;
+    for (int y = range.start; y < range.end; ++y) {
+      const uchar *first = bayer_.ptr<uchar>(2 * y);
+      const uchar *second = bayer_.ptr<uchar>(2 * y + 1);
+      uchar *bgr = bgr_.ptr<uchar>(y);
+      int done = 0;
+#ifdef PROVIDER_VISION_X86
+      if (level_ != SimdLevel::SCALAR) {
+        done = BinRowSse41(first, second, width, layout_, bgr);
+      }
+#endif
+      BinRowScalar(first, second, done, width, layout_, bgr);
+    }
+  }
+
+ private:
+  const cv::Mat &bayer_;
+  QuadLayout layout_;
+  cv::Mat &bgr_;
+  SimdLevel level_;
+};
+
+// Interpolates the row y of the mosaic with the given kernel.
+void DemosaicRow(const cv::Mat &bayer, BayerPattern pattern, int y,
+                 SimdLevel level, uchar *bgr) {
+  const int width = bayer.cols;
+  const int height = bayer.rows;
+  const uchar *row = bayer.ptr<uchar>(y);
+  const uchar *up = bayer.ptr<uchar>(y > 0 ? y - 1 : 1);
+  const uchar *down = bayer.ptr<uchar>(y < height - 1 ? y + 1 : height - 2);
+  const RowLayout layout = GetRowLayout(pattern, y);
+
+  int done = 0;
+#ifdef PROVIDER_VISION_X86
+  if (level == SimdLevel::AVX2) {
+    done = DemosaicRowAvx2(up, row, down, width, layout, bgr);
+  } else if (level == SimdLevel::SSE41) {
+    done = DemosaicRowSse41(up, row, down, width, layout, bgr);
+  }
+#endif
+  if (done == 0) {
+    DemosaicRowScalar(up, row, down, width, 0, width, layout, bgr);
+  } else {
+    DemosaicRowScalar(up, row, down, width, 0, 2, layout, bgr);
+    DemosaicRowScalar(up, row, down, width, done, width, layout, bgr);
+  }
+}
+
+class DemosaicBody : public cv::ParallelLoopBody {
+ public:
+  DemosaicBody(const cv::Mat &bayer, BayerPattern pattern, cv::Mat &bgr,
+               SimdLevel level)
+      : bayer_(bayer), pattern_(pattern), bgr_(bgr), level_(level) {}
+
+  void operator()(const cv::Range &range) const override {
+    for (int y = range.start; y < range.end; ++y) {
+      DemosaicRow(bayer_, pattern_, y, level_, bgr_.ptr<uchar>(y));
+    }
+  }
+
+ private:
+  const cv::Mat &bayer_;
+  BayerPattern pattern_;
+  cv::Mat &bgr_;
+  SimdLevel level_;
+};
+
+// The fixed point maps of cv::remap: the integer part of the coordinates in
+// the first map, and their fractions, in 1/32 of pixel, in the second.
+const int kRemapBits = 5;
+const int kRemapSize = 1 << kRemapBits;
+const int kRemapMask = kRemapSize - 1;
+
+// The rows of the image remapped at once, from the rows of the mosaic they
+// read.
+const int kRemapBandRows = 16;
+
+// The demosaiced rows of the mosaic read by a band of the image. The rows
+// are kept in a ring, so the rows a band shares with the previous one (most
+// of them) are not demosaiced again and the ring stays in the cache.
+class RowCache {
+ public:
+  RowCache() : step_(0), capacity_(0), first_(0), last_(-1) {}
+
+  // Forgets the rows, for another mosaic.
+  void Reset(const cv::Mat &bayer) {
+    step_ = 3 * static_cast<size_t>(bayer.cols);
+    capacity_ = static_cast<int>(data_.size() / step_);
+    first_ = 0;
+    last_ = -1;
+  }
+
+  // Makes the rows [first, last] of the mosaic available and returns their
+  // pointers, indexed from first.
+  const uchar *const *Fill(const cv::Mat &bayer, BayerPattern pattern,
+                           SimdLevel level, int first, int last) {
+    const int count = last - first + 1;
+    if (count > capacity_) {
+      // Only while warming up, the rows are demosaiced again.
+      data_.resize(count * step_);
+      Reset(bayer);
+    }
+    rows_.resize(count);
+    for (int y = first; y <= last; ++y) {
+      // Two rows of the range never share a slot, the range is not longer
+      // than the ring.
+      uchar *row = data_.data() + (y % capacity_) * step_;
+      if (y < first_ || y > last_) {
+        DemosaicRow(bayer, pattern, y, level, row);
+      }
+      rows_[y - first] = row;
+    }
+    first_ = first;
+    last_ = last;
+    return rows_.data();
+  }
+
+ private:
+  std::vector<uchar> data_;
+  std::vector<const uchar *> rows_;
+  size_t step_;
+  // The number of rows of the ring.
+  int capacity_;
+  // The rows in the ring.
+  int first_;
+  int last_;
+};
+
+// Remaps the pixels [begin, end) of a row from the demosaiced rows, indexed
+// from the row first of the mosaic. It is the bilinear interpolation of
+// cv::remap, whose coefficients are these weights scaled by 32, which leaves
+// the rounded result unchanged. The neighbors out of the mosaic are black
+// (BORDER_CONSTANT).
+void RemapRowScalar(const short *xy, const ushort *fraction,
+                    const uchar *const *rows, int first, int width,
+                    int height, int begin, int end, uchar *bgr) {
+  for (int x = begin; x < end; ++x) {
+    const int sx = xy[2 * x];
+    const int sy = xy[2 * x + 1];
+    const int fx = fraction[x] & kRemapMask;
+    const int fy = (fraction[x] >> kRemapBits) & kRemapMask;
+    const int weights[4] = {(kRemapSize - fx) * (kRemapSize - fy),
+                            fx * (kRemapSize - fy), (kRemapSize - fx) * fy,
+                            fx * fy};
+    int sum[3] = {0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+      const int nx = sx + (i & 1);
+      const int ny = sy + (i >> 1);
+      if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+        continue;
+      }
+      const uchar *neighbor = rows[ny - first] + 3 * nx;
+      sum[0] += weights[i] * neighbor[0];
+      sum[1] += weights[i] * neighbor[1];
+      sum[2] += weights[i] * neighbor[2];
+    }
+    const int half = 1 << (2 * kRemapBits - 1);
+    uchar *pixel = bgr + 3 * x;
+    pixel[0] = static_cast<uchar>((sum[0] + half) >> (2 * kRemapBits));
+    pixel[1] = static_cast<uchar>((sum[1] + half) >> (2 * kRemapBits));
+    pixel[2] = static_cast<uchar>((sum[2] + half) >> (2 * kRemapBits));
+  }
+}
+
+#ifdef PROVIDER_VISION_X86
+
+// Same as above, one pixel per iteration: the channels of both neighbors of
+// a row are interpolated horizontally with pmaddubsw (the weights of 1/32
+// fit in a byte), then both rows vertically with pmaddwd. The product of
+// both is the weight of cv::remap. The pixels whose neighbors are not all
+// in the mosaic, or too close to its right border to load 8 bytes, are left
+// to the scalar kernel. The 4 bytes store overlaps the next pixel, so the
+// last one of the row is left to the scalar kernel as well.
+PROVIDER_VISION_TARGET_SSE41 void RemapRowSse41(const short *xy,
+                                                const ushort *fraction,
+                                                const uchar *const *rows,
+                                                int first, int width,
+                                                int height, int end,
+                                                uchar *bgr) {
+  // b0 b1 B0 B1 g0 g1 G0 G1 r0 r1 R0 R1, the upper row in the low half.
+  const __m128i interleave = _mm_setr_epi8(0, 3, 8, 11, 1, 4, 9, 12, 2, 5, 10,
+                                           13, -1, -1, -1, -1);
+  const __m128i half = _mm_set1_epi32(1 << (2 * kRemapBits - 1));
+  for (int x = 0; x < end; ++x) {
+    const int sx = xy[2 * x];
+    const int sy = xy[2 * x + 1];
+    if (sx < 0 || sx > width - 3 || sy < 0 || sy > height - 2) {
+      RemapRowScalar(xy, fraction, rows, first, width, height, x, x + 1, bgr);
+      continue;
+    }
+    const int fx = fraction[x] & kRemapMask;
+    const int fy = (fraction[x] >> kRemapBits) & kRemapMask;
+    const __m128i *upper =
+        reinterpret_cast<const __m128i *>(rows[sy - first] + 3 * sx);
+    const __m128i *lower =
+        reinterpret_cast<const __m128i *>(rows[sy + 1 - first] + 3 * sx);
+    const __m128i pixels =
+        _mm_unpacklo_epi64(_mm_loadl_epi64(upper), _mm_loadl_epi64(lower));
+    const __m128i horizontal = _mm_maddubs_epi16(
+        _mm_shuffle_epi8(pixels, interleave),
+        _mm_set1_epi16(static_cast<short>((fx << 8) | (kRemapSize - fx))));
+    const __m128i sum = _mm_madd_epi16(
+        horizontal, _mm_set1_epi32((fy << 16) | (kRemapSize - fy)));
+    const __m128i pixel =
+        _mm_srai_epi32(_mm_add_epi32(sum, half), 2 * kRemapBits);
+    const __m128i packed =
+        _mm_packus_epi16(_mm_packs_epi32(pixel, pixel), pixel);
+    const int value = _mm_cvtsi128_si32(packed);
+    std::memcpy(bgr + 3 * x, &value, sizeof(value));
+  }
+}
+
+#endif  // PROVIDER_VISION_X86
+
+class DemosaicRemapBody : public cv::ParallelLoopBody {
+ public:
+  DemosaicRemapBody(const cv::Mat &bayer, BayerPattern pattern,
+                    const cv::Mat &map1, const cv::Mat &map2, cv::Mat &bgr,
+                    SimdLevel level)
+      : bayer_(bayer), pattern_(pattern), map1_(map1), map2_(map2),
+        bgr_(bgr), level_(level) {}
+
+  void operator()(const cv::Range &range) const override {
+    // Kept by the thread, the streaming does not allocate once warm.
+    static thread_local RowCache cache;
+    cache.Reset(bayer_);
+    const int width = bayer_.cols;
+    const int height = bayer_.rows;
+
+    for (int start = range.start; start < range.end;
+         start += kRemapBandRows) {
+      const int stop = std::min(start + kRemapBandRows, range.end);
+
+      // The rows of the mosaic the band reads.
+      int first = height, last = -1;
+      for (int y = start; y < stop; ++y) {
+        const short *xy = map1_.ptr<short>(y);
+        for (int x = 0; x < bgr_.cols; ++x) {
+          const int sx = xy[2 * x];
+          const int sy = xy[2 * x + 1];
+          if (sx + 1 >= 0 && sx < width && sy + 1 >= 0 && sy < height) {
+            first = std::min(first, std::max(sy, 0));
+            last = std::max(last, std::min(sy + 1, height - 1));
+          }
+        }
+      }
+      const uchar *const *rows =
+          last >= first
+              ? cache.Fill(bayer_, pattern_, level_, first, last)
+              : nullptr;
+
+      for (int y = start; y < stop; ++y) {
+        const short *xy = map1_.ptr<short>(y);
+        const ushort *fraction = map2_.ptr<ushort>(y);
+        uchar *bgr = bgr_.ptr<uchar>(y);
+        int done = 0;
+#ifdef PROVIDER_VISION_X86
+        if (level_ != SimdLevel::SCALAR) {
+          done = bgr_.cols - 1;
+          RemapRowSse41(xy, fraction, rows, first, width, height, done, bgr);
+        }
+#endif
+        RemapRowScalar(xy, fraction, rows, first, width, height, done,
+                       bgr_.cols, bgr);
+      }
+    }
+  }
+
+ private:
+  const cv::Mat &bayer_;
+  BayerPattern pattern_;
+  const cv::Mat &map1_;
+  const cv::Mat &map2_;
+  cv::Mat &bgr_;
+  SimdLevel level_;
+};
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicBilinear(const cv::Mat &bayer, BayerPattern pattern,
+                      cv::Mat &bgr) {
+  return DemosaicBilinear(bayer, pattern, bgr, GetSimdLevel());
+}
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicBilinear(const cv::Mat &bayer, BayerPattern pattern,
+                      cv::Mat &bgr, SimdLevel level) {
+  if (bayer.type() != CV_8UC1 || bayer.rows < 2 || bayer.cols < 2) {
+    return false;
+  }
+  bgr.create(bayer.rows, bayer.cols, CV_8UC3);
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, bayer.rows),
+      DemosaicBody(bayer, pattern, bgr, ClampSimdLevel(level)));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicBinning(const cv::Mat &bayer, BayerPattern pattern,
+                     cv::Mat &bgr) {
+  return DemosaicBinning(bayer, pattern, bgr, GetSimdLevel());
+}
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicBinning(const cv::Mat &bayer, BayerPattern pattern,
+                     cv::Mat &bgr, SimdLevel level) {
+  if (bayer.type() != CV_8UC1 || bayer.rows < 2 || bayer.cols < 2) {
+    return false;
+  }
+  bgr.create(bayer.rows / 2, bayer.cols / 2, CV_8UC3);
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, bgr.rows),
+      BinningBody(bayer, pattern, bgr, ClampSimdLevel(level)));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicRemap(const cv::Mat &bayer, BayerPattern pattern,
+                   const cv::Mat &map1, const cv::Mat &map2, cv::Mat &bgr) {
+  return DemosaicRemap(bayer, pattern, map1, map2, bgr, GetSimdLevel());
+}
+
+//------------------------------------------------------------------------------
+//
+bool DemosaicRemap(const cv::Mat &bayer, BayerPattern pattern,
+                   const cv::Mat &map1, const cv::Mat &map2, cv::Mat &bgr,
+                   SimdLevel level) {
+  if (bayer.type() != CV_8UC1 || bayer.rows < 2 || bayer.cols < 2 ||
+      map1.type() != CV_16SC2 || map2.type() != CV_16UC1 || map1.empty() ||
+      map1.size() != map2.size()) {
+    return false;
+  }
+  bgr.create(map1.rows, map1.cols, CV_8UC3);
+  // A thread steals a few bands at once, the rows of the mosaic they share
+  // stay in its cache.
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, bgr.rows),
+      DemosaicRemapBody(bayer, pattern, map1, map2, bgr,
+                        ClampSimdLevel(level)),
+      4 * kRemapBandRows);
+  return true;
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,105 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_BAYER_DEMOSAIC_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_BAYER_DEMOSAIC_H_
+
+#include <opencv2/core/core.hpp>
+#include "provider_vision/media/conversion/simd.h"
+
+namespace provider_vision {
+
+/**
+ * The color of the first two pixels of the first two rows of a mosaic, i.e.
+ * RGGB has red on the even rows and columns. Beware, OpenCV names them
+ * after the second row: RGGB is its BayerBG.
+ */
+enum class BayerPattern { RGGB = 0, GRBG, GBRG, BGGR };
+
+/**
+ * Bilinear demosaicing of an 8 bits mosaic in a BGR image.
+ *
+ * Each missing color is the rounded mean of its nearest neighbors of that
+ * color, which is the formula of cv::cvtColor with the CV_Bayer*2BGR codes.
+ * The interior pixels are the same as OpenCV's. On the one pixel border,
+ * OpenCV copies the pixels next to it while the mosaic is mirrored here, so
+ * the border may differ. It runs as the other conversions, see SimdLevel.
+ *
+ * \return False if the mosaic is not a CV_8UC1 image of at least 2x2.
+ */
+bool DemosaicBilinear(const cv::Mat &bayer, BayerPattern pattern,
+                      cv::Mat &bgr);
+
+/**
+ * Same as above, with the given kernel (lowered to what the CPU supports).
+ * For the tests and the benchmarks.
+ */
+bool DemosaicBilinear(const cv::Mat &bayer, BayerPattern pattern,
+                      cv::Mat &bgr, SimdLevel level);
+
+/**
+ * Half resolution demosaicing: every 2x2 quad of the mosaic is a BGR pixel,
+ * made of its red, its blue and the rounded mean of its two greens. There is
+ * no interpolation, the image is a quarter of the mosaic, in a single pass
+ * that costs less than the bilinear one. An odd last row or column is
+ * dropped.
+ *
+ * \return False if the mosaic is not a CV_8UC1 image of at least 2x2.
+ */
+bool DemosaicBinning(const cv::Mat &bayer, BayerPattern pattern,
+                     cv::Mat &bgr);
+
+/**
+ * Same as above, with the given kernel (lowered to what the CPU supports).
+ * The AVX2 level uses the SSE4.1 kernel, the binning is bound by the memory.
+ */
+bool DemosaicBinning(const cv::Mat &bayer, BayerPattern pattern,
+                     cv::Mat &bgr, SimdLevel level);
+
+/**
+ * Bilinear demosaicing and undistortion in a single pass over the mosaic.
+ * The maps are the fixed point ones of cv::initUndistortRectifyMap (CV_16SC2
+ * and CV_16UC1) and the image has their size.
+ *
+ * The image is remapped by bands of rows, in parallel: the rows of the
+ * mosaic a band reads are demosaiced in a buffer that stays in the cache, so
+ * the memory only sees the mosaic read and the image written, not the full
+ * size BGR image in between. The result is the one of DemosaicBilinear
+ * followed by cv::remap with INTER_LINEAR and a black BORDER_CONSTANT, bit
+ * for bit.
+ *
+ * \return False if the mosaic is not a CV_8UC1 image of at least 2x2 or the
+ *         maps are not the fixed point ones.
+ */
+bool DemosaicRemap(const cv::Mat &bayer, BayerPattern pattern,
+                   const cv::Mat &map1, const cv::Mat &map2, cv::Mat &bgr);
+
+/**
+ * Same as above, with the given kernels (lowered to what the CPU supports).
+ * The rows are demosaiced with the kernel of the level, and remapped with
+ * the SSE4.1 kernel at the AVX2 level.
+ */
+bool DemosaicRemap(const cv::Mat &bayer, BayerPattern pattern,
+                   const cv::Mat &map1, const cv::Mat &map2, cv::Mat &bgr,
+                   SimdLevel level);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_BAYER_DEMOSAIC_H_
@@ -0,0 +1,136 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/downsample.h"
+#include <cstring>
+#include "provider_vision/media/work_pool.h"
+
+namespace provider_vision {
+
+namespace {
+
+// Halves the pixels [begin, end) of a pair of rows.
+void DownsampleRowScalar(const uchar *first, const uchar *second,
+                         int channels, int begin, int end, uchar *half) {
+  for (int x = begin; x < end; ++x) {
+    const int left = 2 * x * channels;
+    const int right = left + channels;
+    for (int c = 0; c < channels; ++c) {
+      half[x * channels + c] = static_cast<uchar>(
+          (first[left + c] + first[right + c] + second[left + c] +
+           second[right + c] + 2) >> 2);
+    }
+  }
+}
+
+#ifdef PROVIDER_VISION_X86
+
+// Sums the channels of the pixels 2k and 2k + 1 of 4 BGR pixels, in the 6
+// first 16 bits lanes.
+PROVIDER_VISION_TARGET_SSE41 inline __m128i SumPairs(const uchar *pixels) {
+  const __m128i pairs = _mm_setr_epi8(0, 3, 1, 4, 2, 5, 6, 9, 7, 10, 8, 11,
+                                      -1, -1, -1, -1);
+  return _mm_maddubs_epi16(
+      _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels)), pairs),
+      _mm_set1_epi8(1));
+}
+
+// Halves 4 BGR pixels per iteration, returns the first one it did not halve.
+// The loads read 4 bytes past the 8 pixels of a block, the last blocks are
+// left to the scalar kernel.
+PROVIDER_VISION_TARGET_SSE41 int DownsampleRowSse41(const uchar *first,
+                                                    const uchar *second,
+                                                    int width, uchar *half) {
+  const __m128i two = _mm_set1_epi16(2);
+  // The 6 bytes of the low and of the high half, in 12 bytes.
+  const __m128i gather = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13,
+                                       -1, -1, -1, -1);
+  int x = 0;
+  for (; x + 5 <= width; x += 4) {
+    const uchar *a = first + 6 * x;
+    const uchar *b = second + 6 * x;
+    const __m128i low = _mm_srli_epi16(
+        _mm_add_epi16(_mm_add_epi16(SumPairs(a), SumPairs(b)), two), 2);
+    const __m128i high = _mm_srli_epi16(
+        _mm_add_epi16(_mm_add_epi16(SumPairs(a + 12), SumPairs(b + 12)), two),
+        2);
+    const __m128i pixels =
+        _mm_shuffle_epi8(_mm_packus_epi16(low, high), gather);
+    uchar *out = half + 3 * x;
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), pixels);
+    const int last = _mm_extract_epi32(pixels, 2);
+    std::memcpy(out + 8, &last, sizeof(last));
+  }
+  return x;
+}
+
+#endif  // PROVIDER_VISION_X86
+
+class DownsampleBody : public cv::ParallelLoopBody {
+ public:
+  DownsampleBody(const cv::Mat &image, cv::Mat &half, SimdLevel level)
+      : image_(image), half_(half), level_(level) {}
+
+  void operator()(const cv::Range &range) const override {
+    const int width = half_.cols;
+    const int channels = image_.channels();
+    for (int y = range.start; y < range.end; ++y) {
+      const uchar *first = image_.ptr<uchar>(2 * y);
+      const uchar *second = image_.ptr<uchar>(2 * y + 1);
+      uchar *half = half_.ptr<uchar>(y);
+      int done = 0;
+#ifdef PROVIDER_VISION_X86
+      if (level_ != SimdLevel::SCALAR && channels == 3) {
+        done = DownsampleRowSse41(first, second, width, half);
+      }
+#endif
+      DownsampleRowScalar(first, second, channels, done, width, half);
+    }
+  }
+
+ private:
+  const cv::Mat &image_;
+  cv::Mat &half_;
+  SimdLevel level_;
+};
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+//
+bool DownsampleBox(const cv::Mat &image, cv::Mat &half) {
+  return DownsampleBox(image, half, GetSimdLevel());
+}
+
+//------------------------------------------------------------------------------
+//
+bool DownsampleBox(const cv::Mat &image, cv::Mat &half, SimdLevel level) {
+  if (image.depth() != CV_8U || image.rows < 2 || image.cols < 2) {
+    return false;
+  }
+  half.create(image.rows / 2, image.cols / 2, image.type());
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, half.rows),
+      DownsampleBody(image, half, ClampSimdLevel(level)));
+  return true;
+}
+
+}  // namespace provider_vision
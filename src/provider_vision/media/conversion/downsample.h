@@ -0,0 +1,50 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_DOWNSAMPLE_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_DOWNSAMPLE_H_
+
+#include <opencv2/core/core.hpp>
+#include "provider_vision/media/conversion/simd.h"
+
+namespace provider_vision {
+
+/**
+ * Halves an 8 bits image: every pixel is the rounded mean of a 2x2 block,
+ * channel by channel, as cv::resize with INTER_AREA at a scale of 1/2. An
+ * odd last row or column is dropped.
+ *
+ * It runs as the other conversions (see SimdLevel), but only the 3 channels
+ * images have a vectorized kernel.
+ *
+ * \return False if the image is not an 8 bits image of at least 2x2.
+ */
+bool DownsampleBox(const cv::Mat &image, cv::Mat &half);
+
+/**
+ * Same as above, with the given kernel (lowered to what the CPU supports).
+ * The AVX2 level uses the SSE4.1 kernel, the downsampling is bound by the
+ * memory.
+ */
+bool DownsampleBox(const cv::Mat &image, cv::Mat &half, SimdLevel level);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_DOWNSAMPLE_H_
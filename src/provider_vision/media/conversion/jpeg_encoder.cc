@@ -0,0 +1,362 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/jpeg_encoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <jpeglib.h>
+#include <algorithm>
+#include <memory>
+#include "provider_vision/media/work_pool.h"
+
+#ifndef JCS_EXTENSIONS
+#error "The JPEG encoder needs libjpeg-turbo, for its BGR input."
+#endif
+
+namespace provider_vision {
+
+namespace {
+
+// libjpeg exits the process on an error by default, the encoding of the
+// strip is given up instead.
+struct ErrorManager {
+  jpeg_error_mgr manager;
+  jmp_buf jump;
+};
+
+void JumpOnError(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<ErrorManager *>(cinfo->err)->jump, 1);
+}
+
+void IgnoreMessage(j_common_ptr cinfo) { (void)cinfo; }
+
+// From the BT.601 video range of the cameras to the full range of JFIF.
+struct RangeTables {
+  uchar luma[256];
+  uchar chroma[256];
+
+  RangeTables() {
+    for (int i = 0; i < 256; ++i) {
+      luma[i] = cv::saturate_cast<uchar>((i - 16) * 255.0 / 219.0);
+      chroma[i] = cv::saturate_cast<uchar>((i - 128) * 255.0 / 224.0 + 128.0);
+    }
+  }
+};
+
+const RangeTables &GetRangeTables() {
+  static const RangeTables tables;
+  return tables;
+}
+
+int GetMcuHeight(const cv::Mat &image) {
+  return image.type() == CV_8UC3 ? 16 : 8;
+}
+
+// The planes of 8 rows of an UYVY image, as libjpeg reads them in raw
+// mode. The rows are as wide as the MCU, padded with the last column.
+class UyvyPlanes {
+ public:
+  explicit UyvyPlanes(int width)
+      : width_((width + 15) & ~15),
+        data_(static_cast<size_t>(width_) * 16),
+        rows_() {
+    for (int i = 0; i < 8; ++i) {
+      rows_[0][i] = &data_[i * width_];
+      rows_[1][i] = &data_[8 * width_ + i * width_ / 2];
+      rows_[2][i] = &data_[12 * width_ + i * width_ / 2];
+    }
+    for (int c = 0; c < 3; ++c) {
+      planes_[c] = rows_[c];
+    }
+  }
+
+  // Splits the rows from the first one, the rows past the last one repeat
+  // it.
+  JSAMPIMAGE Fill(const cv::Mat &uyvy, int first, int last) {
+    const RangeTables &tables = GetRangeTables();
+    const int pairs = uyvy.cols / 2;
+    for (int i = 0; i < 8; ++i) {
+      const uchar *src = uyvy.ptr<uchar>(std::min(first + i, last - 1));
+      JSAMPROW y = rows_[0][i];
+      JSAMPROW cb = rows_[1][i];
+      JSAMPROW cr = rows_[2][i];
+      for (int x = 0; x < pairs; ++x) {
+        cb[x] = tables.chroma[src[4 * x]];
+        y[2 * x] = tables.luma[src[4 * x + 1]];
+        cr[x] = tables.chroma[src[4 * x + 2]];
+        y[2 * x + 1] = tables.luma[src[4 * x + 3]];
+      }
+      std::fill(y + 2 * pairs, y + width_, y[2 * pairs - 1]);
+      std::fill(cb + pairs, cb + width_ / 2, cb[pairs - 1]);
+      std::fill(cr + pairs, cr + width_ / 2, cr[pairs - 1]);
+    }
+    return planes_;
+  }
+
+ private:
+  int width_;
+  std::vector<JSAMPLE> data_;
+  JSAMPROW rows_[3][8];
+  JSAMPARRAY planes_[3];
+};
+
+// Encodes the rows [first, last) of the image as a JPEG of their own, in
+// a buffer allocated by libjpeg that the caller frees. No object with a
+// destructor may live here, libjpeg jumps out on an error.
+bool EncodeRows(const cv::Mat &image, int first, int last, int quality,
+                int restart_rows, UyvyPlanes *planes, unsigned char **buffer,
+                unsigned long *size) {
+  jpeg_compress_struct cinfo;
+  ErrorManager error;
+  cinfo.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = JumpOnError;
+  error.manager.output_message = IgnoreMessage;
+  if (setjmp(error.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    return false;
+  }
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, buffer, size);
+
+  cinfo.image_width = static_cast<JDIMENSION>(image.cols);
+  cinfo.image_height = static_cast<JDIMENSION>(last - first);
+  if (image.type() == CV_8UC1) {
+    cinfo.input_components = 1;
+    cinfo.in_color_space = JCS_GRAYSCALE;
+  } else if (image.type() == CV_8UC3) {
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_EXT_BGR;
+  } else {
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_YCbCr;
+  }
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  // The strips must be coded with the same tables to be joined.
+  cinfo.optimize_coding = FALSE;
+  cinfo.restart_in_rows = restart_rows;
+  if (planes) {
+    cinfo.raw_data_in = TRUE;
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 1;
+    cinfo.comp_info[1].h_samp_factor = 1;
+    cinfo.comp_info[1].v_samp_factor = 1;
+    cinfo.comp_info[2].h_samp_factor = 1;
+    cinfo.comp_info[2].v_samp_factor = 1;
+  }
+  jpeg_start_compress(&cinfo, TRUE);
+
+  if (planes) {
+    for (int y = first; y < last; y += 8) {
+      jpeg_write_raw_data(&cinfo, planes->Fill(image, y, last), 8);
+    }
+  } else {
+    JSAMPROW rows[16];
+    for (int y = first; y < last;) {
+      const int count = std::min(last - y, 16);
+      for (int i = 0; i < count; ++i) {
+        rows[i] = const_cast<JSAMPROW>(image.ptr<uchar>(y + i));
+      }
+      y += static_cast<int>(jpeg_write_scanlines(&cinfo, rows, count));
+    }
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return true;
+}
+
+struct Strip {
+  unsigned char *data;
+  unsigned long size;
+  bool encoded;
+};
+
+class StripBody : public cv::ParallelLoopBody {
+ public:
+  StripBody(const cv::Mat &image, int quality, int restart_rows,
+            int strip_rows, std::vector<Strip> &strips)
+      : image_(image),
+        quality_(quality),
+        restart_rows_(restart_rows),
+        strip_rows_(strip_rows),
+        strips_(strips) {}
+
+  void operator()(const cv::Range &range) const override {
+    std::unique_ptr<UyvyPlanes> planes;
+    if (image_.type() == CV_8UC2) {
+      planes.reset(new UyvyPlanes(image_.cols));
+    }
+    for (int i = range.start; i < range.end; ++i) {
+      const int first = i * strip_rows_;
+      const int last = std::min(first + strip_rows_, image_.rows);
+      Strip &strip = strips_[i];
+      strip.encoded =
+          EncodeRows(image_, first, last, quality_, restart_rows_,
+                     planes.get(), &strip.data, &strip.size);
+    }
+  }
+
+ private:
+  const cv::Mat &image_;
+  int quality_;
+  int restart_rows_;
+  int strip_rows_;
+  std::vector<Strip> &strips_;
+};
+
+// The offsets of the frame header (SOF) and of the first byte after the
+// header of the scan (SOS) in a JPEG of libjpeg.
+bool ParseHeaders(const unsigned char *data, size_t size, size_t &frame,
+                  size_t &scan) {
+  frame = 0;
+  size_t position = 2;
+  while (position + 4 <= size && data[position] == 0xFF) {
+    const unsigned char marker = data[position + 1];
+    const size_t length = (data[position + 2] << 8) | data[position + 3];
+    if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2) {
+      frame = position;
+    } else if (marker == 0xDA) {
+      scan = position + 2 + length;
+      return frame != 0 && scan + 2 <= size;
+    }
+    position += 2 + length;
+  }
+  return false;
+}
+
+// Appends the entropy coded data of a strip, numbering its restart markers
+// from the given one.
+void AppendScan(const unsigned char *begin, const unsigned char *end,
+                int &restart, std::vector<uint8_t> &jpeg) {
+  while (begin < end) {
+    const unsigned char *marker = static_cast<const unsigned char *>(
+        memchr(begin, 0xFF, static_cast<size_t>(end - begin)));
+    if (!marker || marker + 1 >= end) {
+      jpeg.insert(jpeg.end(), begin, end);
+      return;
+    }
+    jpeg.insert(jpeg.end(), begin, marker + 1);
+    // A 0xFF of the data is followed by a 0, a restart marker by 0xD0-0xD7.
+    if (marker[1] >= 0xD0 && marker[1] <= 0xD7) {
+      jpeg.push_back(static_cast<uint8_t>(0xD0 + (restart++ & 7)));
+    } else {
+      jpeg.push_back(marker[1]);
+    }
+    begin = marker + 2;
+  }
+}
+
+bool JoinStrips(const std::vector<Strip> &strips, int height,
+                std::vector<uint8_t> &jpeg) {
+  // The headers are the ones of the first strip, with the height of the
+  // image.
+  size_t frame, scan;
+  if (!ParseHeaders(strips[0].data, strips[0].size, frame, scan)) {
+    return false;
+  }
+  size_t total = 0;
+  for (const Strip &strip : strips) {
+    total += strip.size;
+  }
+  jpeg.clear();
+  jpeg.reserve(total + 2 * strips.size());
+  jpeg.assign(strips[0].data, strips[0].data + scan);
+  jpeg[frame + 5] = static_cast<uint8_t>(height >> 8);
+  jpeg[frame + 6] = static_cast<uint8_t>(height & 0xFF);
+
+  int restart = 0;
+  for (size_t i = 0; i < strips.size(); ++i) {
+    size_t strip_frame, strip_scan;
+    if (!ParseHeaders(strips[i].data, strips[i].size, strip_frame,
+                      strip_scan)) {
+      return false;
+    }
+    if (i > 0) {
+      jpeg.push_back(0xFF);
+      jpeg.push_back(static_cast<uint8_t>(0xD0 + (restart++ & 7)));
+    }
+    // Without the end of image marker.
+    AppendScan(strips[i].data + strip_scan,
+               strips[i].data + strips[i].size - 2, restart, jpeg);
+  }
+  jpeg.push_back(0xFF);
+  jpeg.push_back(0xD9);
+  return true;
+}
+
+}  // namespace
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+bool EncodeJpeg(const cv::Mat &image, int quality, int restart_rows,
+                std::vector<uint8_t> &jpeg) {
+  if (image.empty() || (image.type() != CV_8UC1 && image.type() != CV_8UC3 &&
+                        image.type() != CV_8UC2) ||
+      (image.type() == CV_8UC2 && image.cols % 2 != 0)) {
+    return false;
+  }
+  restart_rows = std::max(restart_rows, 0);
+
+  // Whole restart intervals per strip, a few strips per thread.
+  const int mcu_height = GetMcuHeight(image);
+  const int mcu_rows = (image.rows + mcu_height - 1) / mcu_height;
+  int strip_rows = image.rows;
+  const size_t threads = WorkPool::Instance().GetThreadCount();
+  if (restart_rows > 0 && threads > 0) {
+    const int intervals = (mcu_rows + restart_rows - 1) / restart_rows;
+    const int strip_count =
+        std::min(intervals, 4 * static_cast<int>(threads + 1));
+    const int intervals_per_strip =
+        (intervals + strip_count - 1) / strip_count;
+    strip_rows = intervals_per_strip * restart_rows * mcu_height;
+  }
+  std::vector<Strip> strips((image.rows + strip_rows - 1) / strip_rows,
+                            Strip{nullptr, 0, false});
+
+  StripBody body(image, quality, restart_rows, strip_rows, strips);
+  if (strips.size() > 1) {
+    WorkPool::Instance().ParallelFor(
+        cv::Range(0, static_cast<int>(strips.size())), body, 1);
+  } else {
+    body(cv::Range(0, 1));
+  }
+
+  bool result = true;
+  for (const Strip &strip : strips) {
+    result = result && strip.encoded;
+  }
+  if (result && strips.size() == 1) {
+    jpeg.assign(strips[0].data, strips[0].data + strips[0].size);
+  } else if (result) {
+    result = JoinStrips(strips, image.rows, jpeg);
+  }
+  for (const Strip &strip : strips) {
+    free(strip.data);
+  }
+  return result;
+}
+
+}  // namespace provider_vision
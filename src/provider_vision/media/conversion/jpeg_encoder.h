@@ -0,0 +1,54 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_JPEG_ENCODER_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_JPEG_ENCODER_H_
+
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * Encodes an image in JPEG with libjpeg-turbo, straight from the buffer of
+ * the image:
+ *  - BGR (CV_8UC3), subsampled in 4:2:0,
+ *  - grayscale (CV_8UC1),
+ *  - YUV422 in the UYVY order (CV_8UC2, as the IIDC cameras deliver it),
+ *    encoded in 4:2:2 without any conversion to BGR. Its BT.601 video range
+ *    is expanded to the full range of JFIF on the way.
+ *
+ * With a restart marker every restart_rows rows of MCU (16 rows for the
+ * BGR images, 8 for the others), the image is cut in strips at the markers
+ * and the strips are encoded in parallel on the WorkPool, then joined. The
+ * strips share the standard tables, so the result is the very same as a
+ * serial encoding with these markers. Without markers (0), the image is
+ * encoded on the calling thread.
+ *
+ * \return False if the image has another type, is empty, or is an UYVY
+ *         image of an odd width.
+ */
+bool EncodeJpeg(const cv::Mat &image, int quality, int restart_rows,
+                std::vector<uint8_t> &jpeg);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_JPEG_ENCODER_H_
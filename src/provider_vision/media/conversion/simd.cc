@@ -0,0 +1,70 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/simd.h"
+
+namespace provider_vision {
+
+namespace {
+
+SimdLevel DetectSimdLevel() {
+#ifdef PROVIDER_VISION_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SimdLevel::SSE41;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+//
+SimdLevel GetSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+//------------------------------------------------------------------------------
+//
+SimdLevel ClampSimdLevel(SimdLevel level) {
+  const SimdLevel supported = GetSimdLevel();
+  return static_cast<int>(level) < static_cast<int>(supported) ? level
+                                                               : supported;
+}
+
+//------------------------------------------------------------------------------
+//
+const char *GetSimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::AVX2:
+      return "avx2";
+    case SimdLevel::SSE41:
+      return "sse4.1";
+    default:
+      return "scalar";
+  }
+}
+
+}  // namespace provider_vision
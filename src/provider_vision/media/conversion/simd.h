@@ -0,0 +1,102 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_SIMD_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_SIMD_H_
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PROVIDER_VISION_X86 1
+#include <immintrin.h>
+#endif
+
+namespace provider_vision {
+
+/**
+ * The instruction sets the conversion kernels are compiled for. The kernels
+ * are compiled for all of them whatever the flags of the build, and the best
+ * one the CPU supports is picked at runtime.
+ *
+ * The conversions of this directory share the same contract: the rows are
+ * processed in parallel on the WorkPool with the best kernel of the CPU,
+ * every kernel of a conversion gives the very same result, and the image
+ * they write is only reallocated if it does not have the size and type of
+ * the result, so it can be a header on a message.
+ */
+enum class SimdLevel { SCALAR = 0, SSE41, AVX2 };
+
+/**
+ * The best level the CPU supports, detected once.
+ */
+SimdLevel GetSimdLevel();
+
+/**
+ * The given level, lowered to what the CPU supports.
+ */
+SimdLevel ClampSimdLevel(SimdLevel level);
+
+const char *GetSimdLevelName(SimdLevel level);
+
+#ifdef PROVIDER_VISION_X86
+
+#define PROVIDER_VISION_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define PROVIDER_VISION_TARGET_AVX2 __attribute__((target("avx2")))
+
+/**
+ * Interleaves 16 blue, green and red bytes in 48 bytes of BGR pixels.
+ */
+PROVIDER_VISION_TARGET_SSE41 inline void StoreBgr(unsigned char *bgr,
+                                                  __m128i b, __m128i g,
+                                                  __m128i r) {
+  const __m128i b0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1,
+                                   4, -1, -1, 5);
+  const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1,
+                                   -1, 4, -1, -1);
+  const __m128i r0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3,
+                                   -1, -1, 4, -1);
+  const __m128i b1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9,
+                                   -1, -1, 10, -1);
+  const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1,
+                                   9, -1, -1, 10);
+  const __m128i r1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1,
+                                   -1, 9, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14,
+                                   -1, -1, 15, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1,
+                                   14, -1, -1, 15, -1);
+  const __m128i r2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1,
+                                   -1, 14, -1, -1, 15);
+
+  __m128i *out = reinterpret_cast<__m128i *>(bgr);
+  _mm_storeu_si128(out, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b0),
+                                                  _mm_shuffle_epi8(g, g0)),
+                                     _mm_shuffle_epi8(r, r0)));
+  _mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b1),
+                                                      _mm_shuffle_epi8(g, g1)),
+                                         _mm_shuffle_epi8(r, r1)));
+  _mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b2),
+                                                      _mm_shuffle_epi8(g, g2)),
+                                         _mm_shuffle_epi8(r, r2)));
+}
+
+#endif  // PROVIDER_VISION_X86
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_SIMD_H_
@@ -0,0 +1,256 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/conversion/yuv422.h"
+#include <algorithm>
+#include "provider_vision/media/work_pool.h"
+
+namespace provider_vision {
+
+namespace {
+
+// The BT.601 coefficients of OpenCV, in fixed point with 20 bits of
+// fraction. The luma is scaled from [16, 235] and the chroma is centered on
+// 128.
+const int kShift = 20;
+const int kRound = 1 << (kShift - 1);
+const int kCy = 1220542;
+const int kCub = 2116026;
+const int kCug = -409993;
+const int kCvg = -852492;
+const int kCvr = 1673527;
+
+inline uchar Saturate(int value) {
+  return static_cast<uchar>(std::min(std::max(value, 0), 255));
+}
+
+// Converts the pixels [begin, end) of a row, begin and end are even.
+void ConvertRowScalar(const uchar *uyvy, int begin, int end, uchar *bgr) {
+  for (int x = begin; x < end; x += 2) {
+    const uchar *pair = uyvy + 2 * x;
+    const int u = pair[0] - 128;
+    const int v = pair[2] - 128;
+    const int ruv = kRound + kCvr * v;
+    const int guv = kRound + kCvg * v + kCug * u;
+    const int buv = kRound + kCub * u;
+    for (int i = 0; i < 2; ++i) {
+      const int y = std::max(0, pair[1 + 2 * i] - 16) * kCy;
+      uchar *pixel = bgr + 3 * (x + i);
+      pixel[0] = Saturate((y + buv) >> kShift);
+      pixel[1] = Saturate((y + guv) >> kShift);
+      pixel[2] = Saturate((y + ruv) >> kShift);
+    }
+  }
+}
+
+#ifdef PROVIDER_VISION_X86
+
+// The vectorized kernels are the scalar arithmetic in 32 bits lanes, hence
+// the same result.
+
+// Converts 8 pixels (16 bytes of UYVY) in 16 bits lanes of blue, green and
+// red.
+PROVIDER_VISION_TARGET_SSE41 inline void Convert8(const uchar *uyvy,
+                                                  __m128i &b, __m128i &g,
+                                                  __m128i &r) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i pixels =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(uyvy));
+
+  // The chroma of the 4 pairs of pixels, and the luma of the 8 pixels.
+  const __m128i uv = _mm_and_si128(pixels, _mm_set1_epi16(0x00FF));
+  const __m128i u = _mm_sub_epi32(_mm_and_si128(uv, _mm_set1_epi32(0xFFFF)),
+                                  _mm_set1_epi32(128));
+  const __m128i v =
+      _mm_sub_epi32(_mm_srli_epi32(uv, 16), _mm_set1_epi32(128));
+  const __m128i luma = _mm_srli_epi16(pixels, 8);
+
+  const __m128i round = _mm_set1_epi32(kRound);
+  const __m128i ruv =
+      _mm_add_epi32(round, _mm_mullo_epi32(v, _mm_set1_epi32(kCvr)));
+  const __m128i guv = _mm_add_epi32(
+      round, _mm_add_epi32(_mm_mullo_epi32(v, _mm_set1_epi32(kCvg)),
+                           _mm_mullo_epi32(u, _mm_set1_epi32(kCug))));
+  const __m128i buv =
+      _mm_add_epi32(round, _mm_mullo_epi32(u, _mm_set1_epi32(kCub)));
+
+  __m128i channels[3][2];
+  for (int half = 0; half < 2; ++half) {
+    // Pixels 0 to 3 are the pairs 0 and 1, pixels 4 to 7 the pairs 2 and 3.
+    const __m128i y16 = half == 0 ? _mm_unpacklo_epi16(luma, zero)
+                                  : _mm_unpackhi_epi16(luma, zero);
+    const __m128i y = _mm_mullo_epi32(
+        _mm_max_epi32(_mm_sub_epi32(y16, _mm_set1_epi32(16)), zero),
+        _mm_set1_epi32(kCy));
+    const __m128i b_uv = half == 0 ? _mm_shuffle_epi32(buv, 0x50)
+                                   : _mm_shuffle_epi32(buv, 0xFA);
+    const __m128i g_uv = half == 0 ? _mm_shuffle_epi32(guv, 0x50)
+                                   : _mm_shuffle_epi32(guv, 0xFA);
+    const __m128i r_uv = half == 0 ? _mm_shuffle_epi32(ruv, 0x50)
+                                   : _mm_shuffle_epi32(ruv, 0xFA);
+    channels[0][half] = _mm_srai_epi32(_mm_add_epi32(y, b_uv), kShift);
+    channels[1][half] = _mm_srai_epi32(_mm_add_epi32(y, g_uv), kShift);
+    channels[2][half] = _mm_srai_epi32(_mm_add_epi32(y, r_uv), kShift);
+  }
+  b = _mm_packs_epi32(channels[0][0], channels[0][1]);
+  g = _mm_packs_epi32(channels[1][0], channels[1][1]);
+  r = _mm_packs_epi32(channels[2][0], channels[2][1]);
+}
+
+// Returns the first pixel it did not convert.
+PROVIDER_VISION_TARGET_SSE41 int ConvertRowSse41(const uchar *uyvy, int width,
+                                                 uchar *bgr) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i b0, g0, r0, b1, g1, r1;
+    Convert8(uyvy + 2 * x, b0, g0, r0);
+    Convert8(uyvy + 2 * x + 16, b1, g1, r1);
+    StoreBgr(bgr + 3 * x, _mm_packus_epi16(b0, b1), _mm_packus_epi16(g0, g1),
+             _mm_packus_epi16(r0, r1));
+  }
+  return x;
+}
+
+// Converts 16 pixels (32 bytes of UYVY) in 16 bits lanes of blue, green and
+// red, in order.
+PROVIDER_VISION_TARGET_AVX2 inline void Convert16(const uchar *uyvy,
+                                                  __m256i &b, __m256i &g,
+                                                  __m256i &r) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i pixels =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(uyvy));
+
+  // Each 128 bits lane holds 4 pairs of pixels, as in Convert8.
+  const __m256i uv = _mm256_and_si256(pixels, _mm256_set1_epi16(0x00FF));
+  const __m256i u =
+      _mm256_sub_epi32(_mm256_and_si256(uv, _mm256_set1_epi32(0xFFFF)),
+                       _mm256_set1_epi32(128));
+  const __m256i v =
+      _mm256_sub_epi32(_mm256_srli_epi32(uv, 16), _mm256_set1_epi32(128));
+  const __m256i luma = _mm256_srli_epi16(pixels, 8);
+
+  const __m256i round = _mm256_set1_epi32(kRound);
+  const __m256i ruv =
+      _mm256_add_epi32(round, _mm256_mullo_epi32(v, _mm256_set1_epi32(kCvr)));
+  const __m256i guv = _mm256_add_epi32(
+      round, _mm256_add_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(kCvg)),
+                              _mm256_mullo_epi32(u, _mm256_set1_epi32(kCug))));
+  const __m256i buv =
+      _mm256_add_epi32(round, _mm256_mullo_epi32(u, _mm256_set1_epi32(kCub)));
+
+  __m256i channels[3][2];
+  for (int half = 0; half < 2; ++half) {
+    const __m256i y16 = half == 0 ? _mm256_unpacklo_epi16(luma, zero)
+                                  : _mm256_unpackhi_epi16(luma, zero);
+    const __m256i y = _mm256_mullo_epi32(
+        _mm256_max_epi32(_mm256_sub_epi32(y16, _mm256_set1_epi32(16)), zero),
+        _mm256_set1_epi32(kCy));
+    const __m256i b_uv = half == 0 ? _mm256_shuffle_epi32(buv, 0x50)
+                                   : _mm256_shuffle_epi32(buv, 0xFA);
+    const __m256i g_uv = half == 0 ? _mm256_shuffle_epi32(guv, 0x50)
+                                   : _mm256_shuffle_epi32(guv, 0xFA);
+    const __m256i r_uv = half == 0 ? _mm256_shuffle_epi32(ruv, 0x50)
+                                   : _mm256_shuffle_epi32(ruv, 0xFA);
+    channels[0][half] = _mm256_srai_epi32(_mm256_add_epi32(y, b_uv), kShift);
+    channels[1][half] = _mm256_srai_epi32(_mm256_add_epi32(y, g_uv), kShift);
+    channels[2][half] = _mm256_srai_epi32(_mm256_add_epi32(y, r_uv), kShift);
+  }
+  // The unpack and the pack both work within the 128 bits lanes, so they
+  // cancel out: each lane holds its 8 pixels in order.
+  b = _mm256_packs_epi32(channels[0][0], channels[0][1]);
+  g = _mm256_packs_epi32(channels[1][0], channels[1][1]);
+  r = _mm256_packs_epi32(channels[2][0], channels[2][1]);
+}
+
+// Packs two vectors of 16 bits lanes in 32 bytes, in order.
+PROVIDER_VISION_TARGET_AVX2 inline __m256i Pack16(__m256i a, __m256i b) {
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+PROVIDER_VISION_TARGET_AVX2 int ConvertRowAvx2(const uchar *uyvy, int width,
+                                               uchar *bgr) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i b0, g0, r0, b1, g1, r1;
+    Convert16(uyvy + 2 * x, b0, g0, r0);
+    Convert16(uyvy + 2 * x + 32, b1, g1, r1);
+    const __m256i b = Pack16(b0, b1);
+    const __m256i g = Pack16(g0, g1);
+    const __m256i r = Pack16(r0, r1);
+    StoreBgr(bgr + 3 * x, _mm256_castsi256_si128(b),
+             _mm256_castsi256_si128(g), _mm256_castsi256_si128(r));
+    StoreBgr(bgr + 3 * (x + 16), _mm256_extracti128_si256(b, 1),
+             _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(r, 1));
+  }
+  return x;
+}
+
+#endif  // PROVIDER_VISION_X86
+
+class ConversionBody : public cv::ParallelLoopBody {
+ public:
+  ConversionBody(const cv::Mat &uyvy, cv::Mat &bgr, SimdLevel level)
+      : uyvy_(uyvy), bgr_(bgr), level_(level) {}
+
+  void operator()(const cv::Range &range) const override {
+    const int width = uyvy_.cols;
+    for (int y = range.start; y < range.end; ++y) {
+      const uchar *uyvy = uyvy_.ptr<uchar>(y);
+      uchar *bgr = bgr_.ptr<uchar>(y);
+      int done = 0;
+#ifdef PROVIDER_VISION_X86
+      if (level_ == SimdLevel::AVX2) {
+        done = ConvertRowAvx2(uyvy, width, bgr);
+      } else if (level_ == SimdLevel::SSE41) {
+        done = ConvertRowSse41(uyvy, width, bgr);
+      }
+#endif
+      ConvertRowScalar(uyvy, done, width, bgr);
+    }
+  }
+
+ private:
+  const cv::Mat &uyvy_;
+  cv::Mat &bgr_;
+  SimdLevel level_;
+};
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+//
+bool ConvertUyvyToBgr(const cv::Mat &uyvy, cv::Mat &bgr) {
+  return ConvertUyvyToBgr(uyvy, bgr, GetSimdLevel());
+}
+
+//------------------------------------------------------------------------------
+//
+bool ConvertUyvyToBgr(const cv::Mat &uyvy, cv::Mat &bgr, SimdLevel level) {
+  if (uyvy.type() != CV_8UC2 || uyvy.cols % 2 != 0) {
+    return false;
+  }
+  bgr.create(uyvy.rows, uyvy.cols, CV_8UC3);
+  WorkPool::Instance().ParallelFor(
+      cv::Range(0, uyvy.rows),
+      ConversionBody(uyvy, bgr, ClampSimdLevel(level)));
+  return true;
+}
+
+}  // namespace provider_vision
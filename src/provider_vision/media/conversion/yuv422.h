@@ -0,0 +1,49 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_CONVERSION_YUV422_H_
+#define PROVIDER_VISION_MEDIA_CONVERSION_YUV422_H_
+
+#include <opencv2/core/core.hpp>
+#include "provider_vision/media/conversion/simd.h"
+
+namespace provider_vision {
+
+/**
+ * Converts a YUV422 image in the UYVY order (the yuv422 encoding of ROS,
+ * as the IIDC cameras deliver it) in a BGR image.
+ *
+ * It is the BT.601 conversion of cv::cvtColor with CV_YUV2BGR_UYVY, in the
+ * same fixed point arithmetic, so the result is the one of OpenCV 3. It runs
+ * as the other conversions, see SimdLevel.
+ *
+ * \return False if the image is not a CV_8UC2 image of an even width.
+ */
+bool ConvertUyvyToBgr(const cv::Mat &uyvy, cv::Mat &bgr);
+
+/**
+ * Same as above, with the given kernel (lowered to what the CPU supports).
+ * For the tests and the benchmarks.
+ */
+bool ConvertUyvyToBgr(const cv::Mat &uyvy, cv::Mat &bgr, SimdLevel level);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_CONVERSION_YUV422_H_
@@ -0,0 +1,108 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/device_clock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace provider_vision {
+
+namespace {
+
+// How fast the offset may grow, in seconds per second of the device. It
+// covers the drift of a quartz (a few ppm) with a good margin.
+const double kDriftAllowance = 1e-4;
+
+}  // namespace
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+DeviceClock::DeviceClock(double tick_frequency)
+    : tick_frequency_(tick_frequency > 0.0 ? tick_frequency : 1e9),
+      synchronized_(false),
+      offset_(0.0),
+      last_ticks_(0) {}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+ros::Time DeviceClock::ToRosTime(uint64_t ticks, const ros::Time &received) {
+  // The device restarted its clock, the previous offset is meaningless.
+  if (synchronized_ && ticks < last_ticks_) {
+    synchronized_ = false;
+  }
+
+  const double device_time = static_cast<double>(ticks) / tick_frequency_;
+  const double sample = received.toSec() - device_time;
+
+  if (!synchronized_) {
+    offset_ = sample;
+    synchronized_ = true;
+  } else {
+    const double elapsed =
+        static_cast<double>(ticks - last_ticks_) / tick_frequency_;
+    offset_ = std::min(offset_ + kDriftAllowance * elapsed, sample);
+  }
+  last_ticks_ = ticks;
+
+  // Never in the future of the reception, whatever the estimate says.
+  return std::min(ros::Time(device_time + offset_), received);
+}
+
+//------------------------------------------------------------------------------
+//
+void DeviceClock::SetTickFrequency(double tick_frequency) {
+  if (tick_frequency > 0.0 && tick_frequency != tick_frequency_) {
+    tick_frequency_ = tick_frequency;
+    Reset();
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void DeviceClock::Reset() { synchronized_ = false; }
+
+//==============================================================================
+// F U N C T I O N S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+int64_t GetBlockIdDelta(uint64_t previous_id, uint64_t id) {
+  int64_t delta = static_cast<int64_t>(id) - static_cast<int64_t>(previous_id);
+  if (delta <= 0) {
+    delta += 0xFFFF;
+  }
+  return delta;
+}
+
+//------------------------------------------------------------------------------
+//
+int64_t GetFrameCountDelta(uint64_t previous_timestamp, uint64_t timestamp,
+                           double frame_interval) {
+  const double elapsed = (timestamp - previous_timestamp) * 1e-6;
+  return std::max<int64_t>(1, std::llround(elapsed / frame_interval));
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,101 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_DEVICE_CLOCK_H_
+#define PROVIDER_VISION_MEDIA_DEVICE_CLOCK_H_
+
+#include <ros/time.h>
+#include <cstdint>
+#include <memory>
+
+namespace provider_vision {
+
+/**
+ * Maps the timestamps of a device, in ticks of its own clock, to ROS time.
+ *
+ * The offset between both clocks is estimated from the time at which the
+ * host received each frame. The transmission only ever adds delay, so the
+ * smallest offset seen is the best estimate of the real one. It is allowed
+ * to grow slowly, so the estimate follows the drift between both clocks.
+ */
+class DeviceClock {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<DeviceClock>;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit DeviceClock(double tick_frequency = 1e9);
+
+  ~DeviceClock() = default;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Returns the ROS time at which the device took the frame.
+   *
+   * \param ticks The timestamp of the frame, in ticks of the device.
+   * \param received The ROS time at which the host received the frame.
+   */
+  ros::Time ToRosTime(uint64_t ticks, const ros::Time &received);
+
+  void SetTickFrequency(double tick_frequency);
+
+  /**
+   * Forgets the offset, i.e. when the device restarts its clock.
+   */
+  void Reset();
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  double tick_frequency_;
+
+  bool synchronized_;
+
+  // Offset from the device clock to ROS time, in seconds.
+  double offset_;
+
+  uint64_t last_ticks_;
+};
+
+/**
+ * The frames from a GigE Vision 1.x block id to the next one. The ids are
+ * 16 bits and 0 is skipped when they wrap, so an id that does not grow has
+ * wrapped.
+ */
+int64_t GetBlockIdDelta(uint64_t previous_id, uint64_t id);
+
+/**
+ * The frames from a timestamp to a later one, in microseconds, for the
+ * devices that have no frame counter. The frames are evenly spaced, so a
+ * gap of several periods means that frames were lost. It is at least 1.
+ */
+int64_t GetFrameCountDelta(uint64_t previous_timestamp, uint64_t timestamp,
+                           double frame_interval);
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_DEVICE_CLOCK_H_
@@ -0,0 +1,99 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_FRAME_H_
+#define PROVIDER_VISION_MEDIA_FRAME_H_
+
+#include <ros/time.h>
+#include <sensor_msgs/CompressedImage.h>
+#include <sensor_msgs/Image.h>
+#include <cstdint>
+#include <memory>
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * What the media knows about a frame, besides its pixels.
+ */
+struct FrameInfo {
+  // When the frame was taken, in ROS time. Zero if the media does not know,
+  // the streamer then stamps the frame when it gets it.
+  ros::Time stamp;
+
+  // Frame counter of the device, it skips the frames that were lost on the
+  // way. Negative if the media does not count its frames, the streamer then
+  // counts them.
+  int64_t sequence;
+
+  // The frames lost since the previous one, filled by the streamer from the
+  // sequence.
+  uint32_t dropped;
+
+  // The frames already waiting in the driver behind this one.
+  uint32_t frames_behind;
+
+  FrameInfo() : stamp(), sequence(-1), dropped(0), frames_behind(0) {}
+};
+
+/**
+ * A frame is what travels between the stages of the MediaStreamer.
+ *
+ * The raw image is the buffer as it was delivered by the media (i.e. a Bayer
+ * mosaic for the GigE cameras, YUV422 for the DC1394 cameras) and the image
+ * is the result of the conversion stage, in BGR.
+ * Both are cv::Mat, so moving a frame from a stage to another only moves the
+ * headers, the pixels are shared.
+ *
+ * When the MediaStreamer can, the image is a header on the data of the
+ * message, so the converted pixels are written once and the very same
+ * buffer is handed to ROS (without any copy for intra-process subscribers).
+ * The raw message is the buffer of the pool of the media in which the raw
+ * image was acquired, if any. It is only kept past the conversion when the
+ * raw image is published as well.
+ *
+ * When the media hands its own buffer down the pipeline instead of a copy,
+ * the raw image points in this buffer and the lease keeps it from being given
+ * back to the driver. The buffer is given back when the last copy of the
+ * lease is released, which the streamer does as soon as the frame is
+ * converted.
+ *
+ * The pyramid holds the messages of the levels below the image, the first
+ * one is half its size. A level nobody subscribes to has no message.
+ * The compressed message is the JPEG of the image (or of the raw image), if
+ * somebody subscribes to it, and the compressed raw message is the Bayer
+ * mosaic compressed as it is (see EncodeBayer).
+ */
+struct Frame {
+  FrameInfo info;
+  cv::Mat raw;
+  cv::Mat image;
+  sensor_msgs::ImagePtr message;
+  sensor_msgs::ImagePtr raw_message;
+  std::shared_ptr<void> lease;
+  std::vector<sensor_msgs::ImagePtr> pyramid;
+  sensor_msgs::CompressedImagePtr compressed;
+  sensor_msgs::CompressedImagePtr compressed_raw;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_FRAME_H_
@@ -0,0 +1,142 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/frame_pool.h"
+#include <ros/ros.h>
+#include <algorithm>
+#include <boost/make_shared.hpp>
+
+namespace provider_vision {
+
+const size_t FramePool::DEFAULT_SIZE;
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+FramePool::FramePool(size_t size)
+    : buffers_(),
+      size_(size > 0 ? size : 1),
+      allocation_count_(0),
+      exhausted_warned_(false) {}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+void FramePool::Reserve(int rows, int cols, int type) {
+  std::lock_guard<std::mutex> guard(pool_access_);
+
+  // The buffers still referenced elsewhere are simply forgotten, they are
+  // freed by the last one to release them.
+  auto end = std::remove_if(buffers_.begin(), buffers_.end(),
+                            [=](const sensor_msgs::ImagePtr &msg) {
+                              return !HasGeometry(*msg, rows, cols, type);
+                            });
+  buffers_.erase(end, buffers_.end());
+
+  while (buffers_.size() < size_) {
+    buffers_.push_back(Allocate(rows, cols, type));
+    ++allocation_count_;
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+sensor_msgs::ImagePtr FramePool::Acquire(int rows, int cols, int type,
+                                         cv::Mat &image) {
+  std::lock_guard<std::mutex> guard(pool_access_);
+
+  sensor_msgs::ImagePtr buffer;
+  for (auto &elem : buffers_) {
+    // When the pool holds the only reference, nobody can take another one
+    // but us, so the buffer is free.
+    if (elem.unique() && HasGeometry(*elem, rows, cols, type)) {
+      buffer = elem;
+      break;
+    }
+  }
+
+  if (!buffer) {
+    buffer = Allocate(rows, cols, type);
+    ++allocation_count_;
+
+    // Replace a free buffer of another geometry first, then grow the pool.
+    bool kept = false;
+    for (auto &elem : buffers_) {
+      if (elem.unique()) {
+        elem = buffer;
+        kept = true;
+        break;
+      }
+    }
+    if (!kept && buffers_.size() < 2 * size_) {
+      buffers_.push_back(buffer);
+      kept = true;
+    }
+    if (!kept && !exhausted_warned_) {
+      ROS_WARN("The frame pool is exhausted (%lu buffers), the frames are "
+               "released too slowly.",
+               buffers_.size());
+      exhausted_warned_ = true;
+    }
+  }
+
+  // The header fields are set again, a subscriber or a stage may have
+  // changed them on a previous use.
+  buffer->height = static_cast<uint32_t>(rows);
+  buffer->width = static_cast<uint32_t>(cols);
+  buffer->step = static_cast<uint32_t>(cols * CV_ELEM_SIZE(type));
+  image = cv::Mat(rows, cols, type, buffer->data.data(), buffer->step);
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+//
+void FramePool::Resize(size_t size) {
+  std::lock_guard<std::mutex> guard(pool_access_);
+  size_ = size > 0 ? size : 1;
+}
+
+//------------------------------------------------------------------------------
+//
+sensor_msgs::ImagePtr FramePool::Allocate(int rows, int cols, int type) {
+  auto msg = boost::make_shared<sensor_msgs::Image>();
+  msg->height = static_cast<uint32_t>(rows);
+  msg->width = static_cast<uint32_t>(cols);
+  msg->step = static_cast<uint32_t>(cols * CV_ELEM_SIZE(type));
+  msg->is_bigendian = 0;
+  // The resize writes every byte, so the pages are faulted in here and not
+  // during the streaming.
+  msg->data.resize(static_cast<size_t>(msg->step) * rows);
+  return msg;
+}
+
+//------------------------------------------------------------------------------
+//
+bool FramePool::HasGeometry(const sensor_msgs::Image &msg, int rows, int cols,
+                            int type) {
+  return msg.data.size() ==
+         static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type);
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,129 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_FRAME_POOL_H_
+#define PROVIDER_VISION_MEDIA_FRAME_POOL_H_
+
+#include <sensor_msgs/Image.h>
+#include <memory>
+#include <mutex>
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * Pool of preallocated image buffers.
+ *
+ * The buffers are sensor_msgs::Image, so an image acquired or converted in a
+ * buffer of the pool can be published as is. The reference count of the
+ * message is what tells if a buffer is in use: as soon as the pool holds the
+ * only reference (i.e. the frame went through the streamer and the
+ * subscribers are done with it), the buffer is handed out again.
+ * Once the pool is warm, the streaming path does not allocate anymore.
+ */
+class FramePool {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<FramePool>;
+
+  static const size_t DEFAULT_SIZE = 8;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit FramePool(size_t size = DEFAULT_SIZE);
+
+  ~FramePool() = default;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Allocates every buffer of the pool for the given geometry.
+   * The buffers of another geometry are dropped.
+   */
+  void Reserve(int rows, int cols, int type);
+
+  /**
+   * Returns a buffer that nobody else references, with the given geometry.
+   * The image is set as a header on the data of the message, the message
+   * owns the pixels and must be kept as long as the image is used.
+   *
+   * If every buffer is in use, the pool grows up to twice its size, then
+   * falls back to buffers that are not recycled.
+   */
+  sensor_msgs::ImagePtr Acquire(int rows, int cols, int type, cv::Mat &image);
+
+  void Resize(size_t size);
+
+  size_t Size() const;
+
+  /**
+   * The number of buffers that have been allocated since the creation of the
+   * pool. It stops growing once the pool is warm.
+   */
+  size_t AllocationCount() const;
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  static sensor_msgs::ImagePtr Allocate(int rows, int cols, int type);
+
+  static bool HasGeometry(const sensor_msgs::Image &msg, int rows, int cols,
+                          int type);
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  mutable std::mutex pool_access_;
+
+  std::vector<sensor_msgs::ImagePtr> buffers_;
+
+  size_t size_;
+
+  size_t allocation_count_;
+
+  bool exhausted_warned_;
+};
+
+//==============================================================================
+// I N L I N E   F U N C T I O N S   D E F I N I T I O N S
+
+//------------------------------------------------------------------------------
+//
+inline size_t FramePool::Size() const {
+  std::lock_guard<std::mutex> guard(pool_access_);
+  return size_;
+}
+
+//------------------------------------------------------------------------------
+//
+inline size_t FramePool::AllocationCount() const {
+  std::lock_guard<std::mutex> guard(pool_access_);
+  return allocation_count_;
+}
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_FRAME_POOL_H_
@@ -0,0 +1,129 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/latency_histogram.h"
+#include <algorithm>
+
+namespace provider_vision {
+
+const size_t LatencyHistogram::BUCKET_COUNT;
+
+namespace {
+
+// Below this, every microsecond has its own bucket.
+const uint64_t kExactLimit = 8;
+
+const int kBucketsPerOctave = 4;
+
+}  // namespace
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+LatencyHistogram::LatencyHistogram() : max_(0) {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+void LatencyHistogram::Record(double seconds) {
+  const uint64_t microseconds =
+      seconds > 0.0 ? static_cast<uint64_t>(seconds * 1e6) : 0;
+  buckets_[BucketOf(microseconds)].fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (microseconds > max &&
+         !max_.compare_exchange_weak(max, microseconds,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+LatencyHistogram::Summary LatencyHistogram::TakeSummary() {
+  std::array<uint64_t, BUCKET_COUNT> counts;
+  Summary summary = {0, 0.0, 0.0, 0.0, 0.0};
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+    summary.count += counts[i];
+  }
+  summary.max = max_.exchange(0, std::memory_order_relaxed) * 1e-6;
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  // The rank of a percentile is the smallest count that covers it.
+  const uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+  const uint64_t p95_rank = (summary.count * 95 + 99) / 100;
+  const uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+  uint64_t cumulated = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    const uint64_t previous = cumulated;
+    cumulated += counts[i];
+    // The bound of a bucket can be above the maximum, which is exact.
+    const double bound = std::min(UpperBoundOf(i), summary.max);
+    if (previous < p50_rank && cumulated >= p50_rank) summary.p50 = bound;
+    if (previous < p95_rank && cumulated >= p95_rank) summary.p95 = bound;
+    if (previous < p99_rank && cumulated >= p99_rank) summary.p99 = bound;
+  }
+  return summary;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t LatencyHistogram::BucketOf(uint64_t microseconds) {
+  if (microseconds < kExactLimit) {
+    return static_cast<size_t>(microseconds);
+  }
+  const int octave = 63 - __builtin_clzll(microseconds);
+  const int sub_bucket =
+      static_cast<int>(microseconds >> (octave - 2)) & (kBucketsPerOctave - 1);
+  const size_t bucket = kExactLimit + (octave - 3) * kBucketsPerOctave +
+                        static_cast<size_t>(sub_bucket);
+  return std::min(bucket, BUCKET_COUNT - 1);
+}
+
+//------------------------------------------------------------------------------
+//
+double LatencyHistogram::UpperBoundOf(size_t bucket) {
+  if (bucket < kExactLimit) {
+    return (bucket + 1) * 1e-6;
+  }
+  const int octave =
+      static_cast<int>(bucket - kExactLimit) / kBucketsPerOctave + 3;
+  const int sub_bucket =
+      static_cast<int>(bucket - kExactLimit) % kBucketsPerOctave;
+  return static_cast<double>(static_cast<uint64_t>(kBucketsPerOctave + 1 +
+                                                   sub_bucket)
+                             << (octave - 2)) *
+         1e-6;
+}
+
+}  // namespace provider_vision
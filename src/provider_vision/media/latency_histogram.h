@@ -0,0 +1,96 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_LATENCY_HISTOGRAM_H_
+#define PROVIDER_VISION_MEDIA_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace provider_vision {
+
+/**
+ * Histogram of durations that can be recorded from a thread and read from
+ * another one without any lock.
+ *
+ * The buckets are exact up to 8 us, then there are four buckets per power of
+ * two up to about 30 s, so a percentile is known within 25%. The maximum is
+ * exact.
+ */
+class LatencyHistogram {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<LatencyHistogram>;
+
+  static const size_t BUCKET_COUNT = 96;
+
+  /// The percentiles of the durations recorded since the last summary,
+  /// in seconds.
+  struct Summary {
+    uint64_t count;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+  };
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  LatencyHistogram();
+
+  ~LatencyHistogram() = default;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  void Record(double seconds);
+
+  /**
+   * Summarizes the durations recorded since the last call, and starts over.
+   * A duration recorded while the summary is taken may end up in the next
+   * one, but is never lost.
+   */
+  Summary TakeSummary();
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  static size_t BucketOf(uint64_t microseconds);
+
+  // The upper bound of the bucket, in seconds.
+  static double UpperBoundOf(size_t bucket);
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+
+  std::atomic<uint64_t> max_;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,186 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/media_clock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace provider_vision {
+
+namespace {
+
+// The longest a wait lasts before the stop flag is checked again.
+const std::chrono::milliseconds kPollPeriod(100);
+
+}  // namespace
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+MediaClock::MediaClock(double frame_rate, double speed)
+    : clock_access_(),
+      state_changed_(),
+      frame_rate_(std::isfinite(frame_rate) ? std::max(frame_rate, 0.0) : 0.0),
+      speed_(std::isfinite(speed) ? std::max(speed, 0.0) : 0.0),
+      paused_(false),
+      steps_(0),
+      anchored_(false),
+      last_frame_(),
+      next_deadline_() {}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+bool MediaClock::WaitNextFrame(const std::atomic<bool> &stop) {
+  std::unique_lock<std::mutex> lock(clock_access_);
+
+  while (!stop) {
+    const Clock::time_point now = Clock::now();
+
+    if (paused_) {
+      if (steps_ > 0) {
+        --steps_;
+        last_frame_ = now;
+        return true;
+      }
+      state_changed_.wait_for(lock, kPollPeriod);
+      continue;
+    }
+
+    const Clock::duration period = Period();
+    if (period == Clock::duration::zero()) {
+      last_frame_ = now;
+      return true;
+    }
+
+    if (!anchored_) {
+      next_deadline_ = now;
+      anchored_ = true;
+    }
+
+    if (now < next_deadline_) {
+      // A change of state wakes the wait up, everything is evaluated again.
+      state_changed_.wait_until(lock, std::min(next_deadline_, now + kPollPeriod));
+      continue;
+    }
+
+    last_frame_ = now;
+    next_deadline_ += period;
+    // More than a period late (e.g. a frame that was long to decode): the
+    // deadlines start over instead of delivering a burst of frames.
+    if (next_deadline_ < now) {
+      next_deadline_ = now + period;
+    }
+    return true;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::SetFrameRate(double frame_rate) {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  frame_rate_ = std::isfinite(frame_rate) ? std::max(frame_rate, 0.0) : 0.0;
+  Reanchor();
+  state_changed_.notify_all();
+}
+
+//------------------------------------------------------------------------------
+//
+double MediaClock::GetFrameRate() const {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  return frame_rate_;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::SetSpeed(double speed) {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  speed_ = std::isfinite(speed) ? std::max(speed, 0.0) : 0.0;
+  Reanchor();
+  state_changed_.notify_all();
+}
+
+//------------------------------------------------------------------------------
+//
+double MediaClock::GetSpeed() const {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  return speed_;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::Play() {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  if (paused_) {
+    paused_ = false;
+    steps_ = 0;
+    anchored_ = false;
+    state_changed_.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::Pause() {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  paused_ = true;
+  state_changed_.notify_all();
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::Step(unsigned int count) {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  paused_ = true;
+  steps_ += count;
+  state_changed_.notify_all();
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaClock::IsPaused() const {
+  std::lock_guard<std::mutex> guard(clock_access_);
+  return paused_;
+}
+
+//------------------------------------------------------------------------------
+//
+MediaClock::Clock::duration MediaClock::Period() const {
+  if (frame_rate_ <= 0.0 || speed_ <= 0.0) {
+    return Clock::duration::zero();
+  }
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / (frame_rate_ * speed_)));
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaClock::Reanchor() {
+  if (anchored_) {
+    next_deadline_ = last_frame_ + Period();
+  }
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,132 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_MEDIA_CLOCK_H_
+#define PROVIDER_VISION_MEDIA_MEDIA_CLOCK_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace provider_vision {
+
+/**
+ * Paces the playback of the medias that do not have a frame rate of their
+ * own (i.e. images and videos).
+ *
+ * The frames are due at absolute deadlines, one period after the other, so
+ * the time spent to decode and publish a frame does not add up to the period
+ * and the playback does not drift. The period is the one of the frame rate
+ * of the media divided by the speed. A speed of 0 (or a frame rate of 0)
+ * disables the pacing, the frames are then delivered as fast as the
+ * pipeline can handle them.
+ *
+ * The playback can be paused, and stepped frame by frame while paused.
+ */
+class MediaClock {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<MediaClock>;
+
+  using Clock = std::chrono::steady_clock;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit MediaClock(double frame_rate = 0.0, double speed = 1.0);
+
+  ~MediaClock() = default;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Blocks until the next frame is due, or until the stop flag is raised.
+   *
+   * \return False if the wait was interrupted by the stop flag.
+   */
+  bool WaitNextFrame(const std::atomic<bool> &stop);
+
+  void SetFrameRate(double frame_rate);
+
+  double GetFrameRate() const;
+
+  /**
+   * Sets the speed multiplier of the playback, 0 plays the media as fast as
+   * possible.
+   */
+  void SetSpeed(double speed);
+
+  double GetSpeed() const;
+
+  void Play();
+
+  void Pause();
+
+  /**
+   * Pauses the playback and lets the given number of frames go through.
+   */
+  void Step(unsigned int count = 1);
+
+  bool IsPaused() const;
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  // The period between two frames, zero when the playback is not paced.
+  // The lock must be held.
+  Clock::duration Period() const;
+
+  // Moves the next deadline after a change of the period, so the new period
+  // applies from the last frame. The lock must be held.
+  void Reanchor();
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  mutable std::mutex clock_access_;
+
+  std::condition_variable state_changed_;
+
+  double frame_rate_;
+
+  double speed_;
+
+  bool paused_;
+
+  unsigned int steps_;
+
+  // False until the first frame, and after a resume, the deadlines then
+  // start from the next frame.
+  bool anchored_;
+
+  Clock::time_point last_frame_;
+
+  Clock::time_point next_deadline_;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_MEDIA_CLOCK_H_
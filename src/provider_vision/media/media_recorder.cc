@@ -0,0 +1,214 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/media_recorder.h"
+#include <ros/ros.h>
+#include <sensor_msgs/image_encodings.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace provider_vision {
+
+namespace {
+
+// The FOURCC of the encoder, 0 if it is not four characters long.
+int GetFourcc(const std::string &codec) {
+  if (codec.size() != 4) {
+    return 0;
+  }
+  return CV_FOURCC(codec[0], codec[1], codec[2], codec[3]);
+}
+
+// Part 2 of MPEG-4, the encoder of FFmpeg is always built, unlike libx264.
+const char kFallbackCodec[] = "mp4v";
+
+}  // namespace
+
+const size_t MediaRecorder::DEFAULT_QUEUE_DEPTH;
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+MediaRecorder::MediaRecorder(const std::string &path, const std::string &codec,
+                             double frame_rate, size_t queue_depth)
+    : path_(path),
+      codec_(codec),
+      frame_rate_(frame_rate > 0.0 ? frame_rate : 30.0),
+      queue_(queue_depth),
+      stop_(false),
+      writer_(),
+      index_(),
+      size_(),
+      is_color_(true),
+      failed_(false),
+      recorded_(0),
+      thread_() {
+  queue_.SetDropPolicy(ImageRing::DropPolicy::DROP);
+  thread_ = std::thread(&MediaRecorder::EncodingThread, this);
+}
+
+//------------------------------------------------------------------------------
+//
+MediaRecorder::~MediaRecorder() {
+  // The thread empties the queue before it stops.
+  stop_ = true;
+  if (thread_.joinable()) thread_.join();
+}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+bool MediaRecorder::Record(const sensor_msgs::ImageConstPtr &image) {
+  if (!image) {
+    return false;
+  }
+  sensor_msgs::ImageConstPtr queued = image;
+  return queue_.Push(queued, stop_);
+}
+
+//------------------------------------------------------------------------------
+//
+std::string MediaRecorder::MakePath(const std::string &directory,
+                                    const std::string &name) {
+  mkdir(directory.c_str(), 0755);
+  std::string file_name = name;
+  std::replace(file_name.begin(), file_name.end(), '/', '_');
+  std::replace(file_name.begin(), file_name.end(), ' ', '_');
+
+  const std::time_t now = std::time(nullptr);
+  std::tm local;
+  localtime_r(&now, &local);
+  char date[32];
+  std::strftime(date, sizeof(date), "%Y-%m-%d-%H-%M-%S", &local);
+
+  std::string path = directory;
+  if (!path.empty() && path.back() != '/') {
+    path += '/';
+  }
+  return path + file_name + "_" + date + ".mp4";
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaRecorder::EncodingThread() {
+  sensor_msgs::ImageConstPtr image;
+  while (queue_.Pop(image, stop_)) {
+    try {
+      Write(*image);
+    } catch (std::exception &e) {
+      ROS_ERROR_THROTTLE(1.0, "Exception caught in the recorder of %s : %s",
+                         path_.c_str(), e.what());
+    }
+    // Gives the buffer back to the pool of the streamer.
+    image.reset();
+  }
+  if (writer_.isOpened()) {
+    // Writes the trailer of the container, the video is not readable
+    // without it.
+    writer_.release();
+    index_.close();
+    ROS_INFO("%lu frames recorded in %s",
+             static_cast<unsigned long>(recorded_.load()), path_.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaRecorder::Write(const sensor_msgs::Image &message) {
+  int type;
+  if (message.encoding == sensor_msgs::image_encodings::BGR8) {
+    type = CV_8UC3;
+  } else if (message.encoding == sensor_msgs::image_encodings::MONO8) {
+    type = CV_8UC1;
+  } else {
+    ROS_WARN_THROTTLE(10.0, "The %s images cannot be recorded in %s.",
+                      message.encoding.c_str(), path_.c_str());
+    return;
+  }
+  const cv::Mat image(static_cast<int>(message.height),
+                      static_cast<int>(message.width), type,
+                      const_cast<uint8_t *>(message.data.data()),
+                      message.step);
+  const bool is_color = type == CV_8UC3;
+
+  if (!writer_.isOpened() && !failed_) {
+    failed_ = !Open(image.size(), is_color);
+  }
+  if (failed_) {
+    return;
+  }
+  if (image.size() != size_ || is_color != is_color_) {
+    // The geometry of a video is set once and for all.
+    ROS_WARN_THROTTLE(10.0, "The images changed from %dx%d to %dx%d, they "
+                      "are not recorded in %s anymore.",
+                      size_.width, size_.height, image.cols, image.rows,
+                      path_.c_str());
+    return;
+  }
+
+  writer_.write(image);
+  char stamp[32];
+  snprintf(stamp, sizeof(stamp), "%u.%09u", message.header.stamp.sec,
+           message.header.stamp.nsec);
+  index_ << recorded_.load() << "," << message.header.seq << "," << stamp << "\n";
+  ++recorded_;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaRecorder::Open(const cv::Size &size, bool is_color) {
+  std::string codec = codec_;
+  writer_.open(path_, GetFourcc(codec), frame_rate_, size, is_color);
+  if (!writer_.isOpened() && codec != kFallbackCodec) {
+    ROS_WARN("No \"%s\" encoder to record %s, falling back to \"%s\".",
+             codec.c_str(), path_.c_str(), kFallbackCodec);
+    codec = kFallbackCodec;
+    writer_.open(path_, GetFourcc(codec), frame_rate_, size, is_color);
+  }
+  if (!writer_.isOpened()) {
+    ROS_ERROR("The video %s could not be opened, nothing is recorded.",
+              path_.c_str());
+    return false;
+  }
+
+  const std::string index_path = path_ + ".csv";
+  index_.open(index_path.c_str());
+  if (!index_) {
+    ROS_ERROR("The index %s could not be opened, nothing is recorded.",
+              index_path.c_str());
+    writer_.release();
+    return false;
+  }
+  index_ << "frame,sequence,stamp\n";
+
+  size_ = size;
+  is_color_ = is_color;
+  ROS_INFO("Recording the %dx%d images in %s (%s, %.2f fps)", size.width,
+           size.height, path_.c_str(), codec.c_str(), frame_rate_);
+  return true;
+}
+
+}  // namespace provider_vision
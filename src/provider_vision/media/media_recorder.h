@@ -0,0 +1,168 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_MEDIA_RECORDER_H_
+#define PROVIDER_VISION_MEDIA_MEDIA_RECORDER_H_
+
+#include <sensor_msgs/Image.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <string>
+#include <thread>
+#include "provider_vision/media/spsc_ring.h"
+
+namespace provider_vision {
+
+/**
+ * Records the images of a stream in a video, on a thread of its own.
+ *
+ * The images are encoded by the software encoders of OpenCV (FFmpeg), in
+ * H.264 by default, or in MPEG-4 part 2 when no H.264 encoder is available.
+ * The video is opened on the first image, with its geometry, and can be
+ * played back with a VideoFile.
+ *
+ * The rate of a video is constant while the frames of a camera are not, so
+ * the capture stamp and the sequence of every frame of the video are written
+ * in an index next to it (the path of the video followed by .csv), one line
+ * per frame, in the order of the video.
+ *
+ * The images wait for the encoder in a bounded queue. When the encoder
+ * cannot keep up, the images that do not fit are dropped and the streamer
+ * never waits for it.
+ */
+class MediaRecorder {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<MediaRecorder>;
+
+  using ImageRing = SpscRing<sensor_msgs::ImageConstPtr>;
+
+  static const size_t DEFAULT_QUEUE_DEPTH = 4;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  /**
+   * \param codec The FOURCC of the encoder, i.e. "avc1" for H.264 or "mp4v"
+   *        for MPEG-4 part 2.
+   * \param frame_rate The rate stored in the video.
+   */
+  MediaRecorder(const std::string &path, const std::string &codec,
+                double frame_rate, size_t queue_depth = DEFAULT_QUEUE_DEPTH);
+
+  /**
+   * Encodes the images still in the queue and closes the video.
+   */
+  ~MediaRecorder();
+
+  MediaRecorder(const MediaRecorder &) = delete;
+  MediaRecorder &operator=(const MediaRecorder &) = delete;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Queues the image for the encoder, only BGR8 and MONO8 images are
+   * recorded. The image is encoded from the message itself, it must not be
+   * modified afterwards. Only one thread may call it.
+   *
+   * \return False if the image has been dropped.
+   */
+  bool Record(const sensor_msgs::ImageConstPtr &image);
+
+  const std::string &GetPath() const;
+
+  uint64_t GetRecordedCount() const;
+
+  /**
+   * The images dropped because the queue was full.
+   */
+  uint64_t GetDroppedCount() const;
+
+  /**
+   * The path of a new video in the directory, named after the stream and
+   * the current date, like the bags of rosbag.
+   */
+  static std::string MakePath(const std::string &directory,
+                              const std::string &name);
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  void EncodingThread();
+
+  void Write(const sensor_msgs::Image &message);
+
+  // Opens the video and its index for images of the given geometry.
+  bool Open(const cv::Size &size, bool is_color);
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  std::string path_;
+
+  std::string codec_;
+
+  double frame_rate_;
+
+  ImageRing queue_;
+
+  std::atomic<bool> stop_;
+
+  // Only accessed by the encoding thread.
+  cv::VideoWriter writer_;
+  std::ofstream index_;
+  cv::Size size_;
+  bool is_color_;
+  // Set when the video could not be opened, nothing is recorded then.
+  bool failed_;
+
+  std::atomic<uint64_t> recorded_;
+
+  std::thread thread_;
+};
+
+//==============================================================================
+// I N L I N E   F U N C T I O N S   D E F I N I T I O N S
+
+//------------------------------------------------------------------------------
+//
+inline const std::string &MediaRecorder::GetPath() const { return path_; }
+
+//------------------------------------------------------------------------------
+//
+inline uint64_t MediaRecorder::GetRecordedCount() const { return recorded_; }
+
+//------------------------------------------------------------------------------
+//
+inline uint64_t MediaRecorder::GetDroppedCount() const {
+  return queue_.DroppedCount();
+}
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_MEDIA_RECORDER_H_
@@ -18,39 +18,332 @@
 /// You should have received a copy of the GNU General Public License
 /// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <thread>
+#include <boost/make_shared.hpp>
 
 #include "provider_vision/media/media_streamer.h"
+#include "provider_vision/media/conversion/downsample.h"
+#include "provider_vision/media/conversion/jpeg_encoder.h"
 
 namespace provider_vision {
 
+namespace {
+
+std::string EncodingFromType(int type) {
+  switch (type) {
+    case CV_8UC1:
+      return sensor_msgs::image_encodings::MONO8;
+    case CV_16UC1:
+      return sensor_msgs::image_encodings::MONO16;
+    case CV_8UC4:
+      return sensor_msgs::image_encodings::BGRA8;
+    default:
+      return sensor_msgs::image_encodings::BGR8;
+  }
+}
+
+using SteadyClock = std::chrono::steady_clock;
+
+const char *kStageNames[] = {"acquisition", "conversion", "undistortion",
+                             "pyramid",     "encoding",   "publishing"};
+
+void AddValue(diagnostic_msgs::DiagnosticStatus &status,
+              const std::string &key, const std::string &value) {
+  diagnostic_msgs::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = value;
+  status.values.push_back(key_value);
+}
+
+void AddValue(diagnostic_msgs::DiagnosticStatus &status,
+              const std::string &key, double value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.3f", value);
+  AddValue(status, key, std::string(buffer));
+}
+
+void AddValue(diagnostic_msgs::DiagnosticStatus &status,
+              const std::string &key, uint64_t value) {
+  AddValue(status, key, std::to_string(value));
+}
+
+void AddLatency(diagnostic_msgs::DiagnosticStatus &status,
+                const std::string &name,
+                const LatencyHistogram::Summary &summary) {
+  AddValue(status, name + " p50 (ms)", summary.p50 * 1e3);
+  AddValue(status, name + " p95 (ms)", summary.p95 * 1e3);
+  AddValue(status, name + " p99 (ms)", summary.p99 * 1e3);
+  AddValue(status, name + " max (ms)", summary.max * 1e3);
+}
+
+}  // namespace
+
+const size_t MediaStreamer::STAGE_COUNT;
 
 //==============================================================================
 // C / D T O R S   S E C T I O N
 
 //------------------------------------------------------------------------------
 //
-MediaStreamer::MediaStreamer(BaseMedia::Ptr cam, ros::NodeHandle &node_handle, const std::string &topic_name,
+MediaStreamer::MediaStreamer(BaseMedia::Ptr cam, const CameraConfiguration &config,
+                             ros::NodeHandle &node_handle, const std::string &topic_name,
                              int artificialFrameRateMs)
     : media_(cam),
+      config_(config),
+      mode_(config.streamer_mode_ == "pipelined" ? Mode::PIPELINED
+                                                 : Mode::SEQUENTIAL),
       stop_thread_(false),
-      thread_(std::bind(&MediaStreamer::BroadcastThread, this)),
+      convert_queue_(static_cast<size_t>(config.convert_queue_depth_)),
+      publish_queue_(static_cast<size_t>(config.publish_queue_depth_)),
+      thread_(),
+      conversion_thread_(),
+      publishing_thread_(),
       image_publisher_(),
       it_(node_handle),
-      frame_rate_(artificialFrameRateMs)
+      raw_publisher_(),
+      publish_raw_(false),
+      compressed_publisher_(),
+      publish_compressed_(false),
+      compress_raw_(false),
+      compressed_raw_publisher_(),
+      publish_compressed_raw_(false),
+      bayer_codec_(BayerCodec::LOSSLESS),
+      pool_(static_cast<size_t>(config.frame_pool_size_)),
+      clock_(),
+      last_sequence_(-1),
+      dropped_frames_(0),
+      stage_latencies_(),
+      capture_latency_(),
+      published_frames_(0),
+      diagnostics_publisher_(),
+      diagnostics_timer_(),
+      last_diagnostics_(ros::WallTime::now()),
+      last_published_frames_(0),
+      last_dropped_frames_(0),
+      last_queue_drops_(0),
+      output_size_(),
+      output_type_(-1),
+      undistortion_(),
+      undistort_(false),
+      pyramid_publishers_(),
+      pyramid_pools_(),
+      pyramid_box_(config.pyramid_filter_ == "box"),
+      qos_stream_(-1),
+      recorder_()
 {
+  if (config.jpeg_output_ && mode_ == Mode::SEQUENTIAL) {
+    // The encoding would run on the acquisition thread and delay the next
+    // frame by as much.
+    ROS_WARN("%s publishes JPEG images, it streams in pipelined mode so the "
+             "acquisition does not wait for the encoder.",
+             media_->GetName().c_str());
+    mode_ = Mode::PIPELINED;
+  }
+
+  if (config.jpeg_output_) {
+    // The compressed transport of image_transport would advertise the same
+    // topic, it is disabled for this publisher.
+    const std::string parameter =
+        node_handle.resolveName(topic_name) + "/disable_pub_plugins";
+    std::vector<std::string> disabled_plugins;
+    node_handle.getParam(parameter, disabled_plugins);
+    if (std::find(disabled_plugins.begin(), disabled_plugins.end(),
+                  "image_transport/compressed") == disabled_plugins.end()) {
+      disabled_plugins.push_back("image_transport/compressed");
+      node_handle.setParam(parameter, disabled_plugins);
+    }
+  }
+
   // Create the broadcast topic.
   image_publisher_ = it_.advertise(topic_name, 100);
+
+  if (config.jpeg_output_) {
+    compressed_publisher_ = node_handle.advertise<sensor_msgs::CompressedImage>(
+        topic_name + "/compressed", 100);
+    publish_compressed_ = true;
+  }
+
+  if (config.output_mode_ == "raw") {
+    if (media_->GetRawEncoding().empty()) {
+      ROS_WARN("%s has no raw image to publish, only the color image will be.",
+               media_->GetName().c_str());
+    } else {
+      raw_publisher_ = it_.advertise(topic_name + "/raw", 100);
+      publish_raw_ = true;
+      ROS_INFO("%s publishes its %s images on %s/raw",
+               media_->GetName().c_str(), media_->GetRawEncoding().c_str(),
+               topic_name.c_str());
+    }
+  }
+
+  if (config.bayer_compression_ != "none") {
+    if (!sensor_msgs::image_encodings::isBayer(media_->GetRawEncoding())) {
+      ROS_WARN("%s has no Bayer mosaic to compress.",
+               media_->GetName().c_str());
+    } else if (config.bayer_compression_ != "jpeg" &&
+               config.bayer_compression_ != "lossless") {
+      ROS_WARN("Unknown Bayer compression \"%s\", the mosaic of %s is not "
+               "compressed.",
+               config.bayer_compression_.c_str(), media_->GetName().c_str());
+    } else {
+      bayer_codec_ = config.bayer_compression_ == "jpeg" ? BayerCodec::JPEG
+                                                         : BayerCodec::LOSSLESS;
+      compressed_raw_publisher_ =
+          node_handle.advertise<sensor_msgs::CompressedImage>(
+              topic_name + "/bayer", 100);
+      publish_compressed_raw_ = true;
+      ROS_INFO("%s publishes its %s mosaic compressed in %s on %s/bayer",
+               media_->GetName().c_str(), media_->GetRawEncoding().c_str(),
+               config.bayer_compression_.c_str(), topic_name.c_str());
+    }
+  }
+
+  if (media_->HasArtificialFramerate()) {
+    // The rate of the configuration first, then the one stored in the media,
+    // then the default one of the streamer.
+    double frame_rate = config.playback_frame_rate_;
+    if (frame_rate <= 0.0) {
+      frame_rate = media_->GetFrameRate();
+    }
+    if (frame_rate <= 0.0) {
+      frame_rate = artificialFrameRateMs;
+    }
+    clock_.SetFrameRate(frame_rate);
+    clock_.SetSpeed(config.playback_speed_);
+    ROS_INFO("%s is played at %.2f fps, speed x%.2f%s",
+             media_->GetName().c_str(), frame_rate, config.playback_speed_,
+             config.playback_speed_ <= 0.0 ? " (as fast as possible)" : "");
+  }
+
+  if (config.undistortion_) {
+    undistortion_.InitMatrices(config.undistortion_matrice_path_);
+    if (!undistortion_.IsCorrectionEnable()) {
+      ROS_WARN("%s has no valid calibration in \"%s\", its images will not "
+               "be undistorted.",
+               media_->GetName().c_str(),
+               config.undistortion_matrice_path_.c_str());
+    } else {
+      undistort_ = true;
+      // Most likely the size of the images, the maps are ready before the
+      // first frame. Another size is prepared when it comes.
+      undistortion_.PrepareMaps(undistortion_.GetCalibrationSize());
+    }
+  }
+
+  if (publish_compressed_) {
+    compress_raw_ =
+        media_->GetRawEncoding() == sensor_msgs::image_encodings::YUV422 &&
+        !undistort_;
+    ROS_INFO("%s publishes JPEG images of its %s image on %s/compressed "
+             "(quality %d, restart every %d rows of blocks)",
+             media_->GetName().c_str(), compress_raw_ ? "raw" : "color",
+             topic_name.c_str(), config.jpeg_quality_,
+             config.jpeg_restart_rows_);
+  }
+
+  if (config.pyramid_levels_ > 0) {
+    if (config.pyramid_filter_ != "gaussian" && !pyramid_box_) {
+      ROS_WARN("Unknown pyramid filter \"%s\", the gaussian one is used.",
+               config.pyramid_filter_.c_str());
+    }
+    for (int level = 1; level <= config.pyramid_levels_; ++level) {
+      pyramid_publishers_.push_back(
+          it_.advertise(topic_name + "/level" + std::to_string(level), 100));
+      pyramid_pools_.emplace_back(new FramePool(
+          static_cast<size_t>(config.frame_pool_size_)));
+    }
+    ROS_INFO("%s publishes %d levels of %s pyramid on %s/level*",
+             media_->GetName().c_str(), config.pyramid_levels_,
+             pyramid_box_ ? "box" : "gaussian", topic_name.c_str());
+  }
+
+  StreamScheduler::Policy policy;
+  policy.priority = config.qos_priority_;
+  policy.target_fps = config.qos_target_fps_;
+  policy.min_fps = config.qos_min_fps_;
+  policy.max_latency = config.qos_max_latency_;
+  qos_stream_ = StreamScheduler::Instance().Register(media_->GetName(), policy);
+  if (policy.target_fps > 0.0 || policy.max_latency > 0.0) {
+    ROS_INFO("%s has the QoS priority %d (target %.1f fps, at least %.1f "
+             "fps when throttled)",
+             media_->GetName().c_str(), policy.priority, policy.target_fps,
+             policy.min_fps);
+  }
+
+  if (!config.recording_directory_.empty()) {
+    // The rate of the configuration first, then the rate at which the
+    // stream is published or played.
+    double recording_fps = config.recording_fps_;
+    if (recording_fps <= 0.0) {
+      recording_fps = config.qos_target_fps_;
+    }
+    if (recording_fps <= 0.0 && media_->HasArtificialFramerate()) {
+      recording_fps = clock_.GetFrameRate();
+    }
+    if (recording_fps <= 0.0) {
+      recording_fps = config.framerate_;
+    }
+    recorder_ = std::make_shared<MediaRecorder>(
+        MediaRecorder::MakePath(config.recording_directory_,
+                                media_->GetName()),
+        config.recording_codec_, recording_fps,
+        static_cast<size_t>(std::max(config.recording_queue_depth_, 1)));
+    ROS_INFO("%s records its images in %s", media_->GetName().c_str(),
+             recorder_->GetPath().c_str());
+  }
+
+  if (config.diagnostics_period_ > 0.0) {
+    diagnostics_publisher_ =
+        node_handle.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics",
+                                                                10);
+    diagnostics_timer_ = node_handle.createWallTimer(
+        ros::WallDuration(config.diagnostics_period_),
+        &MediaStreamer::PublishDiagnostics, this);
+  }
+
+  // The threads are started once the publisher exists, they would publish on
+  // an invalid publisher otherwise.
+  if (mode_ == Mode::PIPELINED) {
+    convert_queue_.SetDropPolicy(
+        FrameRing::ParseDropPolicy(config.convert_queue_policy_));
+    publish_queue_.SetDropPolicy(
+        FrameRing::ParseDropPolicy(config.publish_queue_policy_));
+    ROS_INFO("%s streams in pipelined mode (convert queue: %lu %s, publish "
+             "queue: %lu %s)",
+             media_->GetName().c_str(), convert_queue_.Capacity(),
+             config.convert_queue_policy_.c_str(), publish_queue_.Capacity(),
+             config.publish_queue_policy_.c_str());
+    publishing_thread_ = std::thread(&MediaStreamer::PublishingThread, this);
+    conversion_thread_ = std::thread(&MediaStreamer::ConversionThread, this);
+    thread_ = std::thread(&MediaStreamer::AcquisitionThread, this);
+  } else {
+    thread_ = std::thread(&MediaStreamer::BroadcastThread, this);
+  }
+  ApplyThreadSettings();
 }
 
 //------------------------------------------------------------------------------
 //
 MediaStreamer::~MediaStreamer() {
-  // Set the flag to stop the thread and wait for it to stop
+  // The diagnostics read the queues, they are stopped first.
+  diagnostics_timer_.stop();
+  // Set the flag to stop the threads and wait for them to stop
   stop_thread_ = true;
-  thread_.join();
+  if (thread_.joinable()) thread_.join();
+  if (conversion_thread_.joinable()) conversion_thread_.join();
+  if (publishing_thread_.joinable()) publishing_thread_.join();
+  StreamScheduler::Instance().Unregister(qos_stream_);
+  // Encodes what is left in its queue and closes the video.
+  recorder_.reset();
   // Shutdown the topic
   image_publisher_.shutdown();
+  raw_publisher_.shutdown();
+  compressed_publisher_.shutdown();
+  compressed_raw_publisher_.shutdown();
+  for (auto &publisher : pyramid_publishers_) {
+    publisher.shutdown();
+  }
   ROS_INFO("%s closed", media_->GetName().c_str());
 }
 
@@ -63,36 +356,13 @@ void MediaStreamer::BroadcastThread() {
   // Starting a timer for timing the acquisition of the image from the media.
   atlas::MilliTimer timer;
   timer.Start();
-  cv::Mat image;
-  cv_bridge::CvImage ros_image;
+  Frame frame;
 
   while (!stop_thread_) {
-    bool result = false;
     try
     {
-      result = media_->NextImage(image);
-
-      // We gotta a image
-      if (!image.empty() && result) {
-        //publish image
-        ros_image.image = image;
-        ros_image.encoding = sensor_msgs::image_encodings::BGR8;
-        image_publisher_.publish(ros_image.toImageMsg());
-        // Reset the timer for next acquisition
-        timer.Reset();
-
-      } else {
-        // if we have received any images in 1 sec, there is a problem
-        if( timer.Seconds() > 1) {
-          ROS_ERROR("Media streamer %s haven't broadcast new image for 1 sec.",
-                    media_->GetName().c_str());
-          timer.Reset();
-        }
-      }
-
-      // For the files, we set a fixed framerate at 15 fps
-      if (media_->HasArtificialFramerate()) {
-        usleep(int(1000000.0f * (1.0f/frame_rate_)));
+      if (AcquireFrame(frame, timer) && ConvertFrame(frame)) {
+        PublishFrame(frame);
       }
     }catch (std::exception &e)
     {
@@ -101,4 +371,573 @@ void MediaStreamer::BroadcastThread() {
     }
   }
 }
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::AcquisitionThread() {
+  atlas::MilliTimer timer;
+  timer.Start();
+
+  while (!stop_thread_) {
+    // A new frame each time, the previous one now belongs to the next stage.
+    Frame frame;
+    try {
+      if (AcquireFrame(frame, timer)) {
+        convert_queue_.Push(frame, stop_thread_);
+      }
+    } catch (std::exception &e) {
+      ROS_ERROR("Exception caught in acquisition thread of %s : %s",
+                media_->GetName().c_str(), e.what());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::ConversionThread() {
+  Frame frame;
+  while (convert_queue_.Pop(frame, stop_thread_)) {
+    try {
+      if (ConvertFrame(frame)) {
+        // The image is not needed anymore, only the messages are published.
+        frame.image.release();
+        publish_queue_.Push(frame, stop_thread_);
+      }
+    } catch (std::exception &e) {
+      ROS_ERROR("Exception caught in conversion thread of %s : %s",
+                media_->GetName().c_str(), e.what());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::PublishingThread() {
+  Frame frame;
+  while (publish_queue_.Pop(frame, stop_thread_)) {
+    try {
+      PublishFrame(frame);
+    } catch (std::exception &e) {
+      ROS_ERROR("Exception caught in publishing thread of %s : %s",
+                media_->GetName().c_str(), e.what());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::AcquireFrame(Frame &frame, atlas::MilliTimer &timer) {
+  // The files are paced by the media clock, the cameras by their hardware.
+  // The time spent waiting (or paused) does not count as a media failure.
+  if (media_->HasArtificialFramerate()) {
+    timer.Pause();
+    const bool running = clock_.WaitNextFrame(stop_thread_);
+    timer.Unpause();
+    if (!running) {
+      return false;
+    }
+  }
+
+  frame.info = FrameInfo();
+  const SteadyClock::time_point start = SteadyClock::now();
+  bool result = media_->NextFrame(frame);
+  RecordLatency(Stage::ACQUISITION, start);
+
+  // We gotta a image
+  if (!frame.raw.empty() && result) {
+    // Reset the timer for next acquisition
+    timer.Reset();
+    FillFrameInfo(frame.info);
+    // The frame is skipped before any work is done on it, when the rate of
+    // the stream is above its target or throttled in favor of the more
+    // important ones.
+    if (!StreamScheduler::Instance().Admit(qos_stream_)) {
+      frame.raw.release();
+      frame.raw_message.reset();
+      frame.lease.reset();
+      result = false;
+    }
+  } else {
+    result = false;
+    // if we have received any images in 1 sec, there is a problem
+    if( timer.Seconds() > 1) {
+      ROS_ERROR("Media streamer %s haven't broadcast new image for 1 sec.",
+                media_->GetName().c_str());
+      timer.Reset();
+    }
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::FillFrameInfo(FrameInfo &info) {
+  if (info.stamp.isZero()) {
+    info.stamp = ros::Time::now();
+  }
+  if (info.sequence < 0) {
+    info.sequence = last_sequence_ + 1;
+  }
+
+  // A gap in the sequence of the device is a frame lost before reaching us.
+  info.dropped = 0;
+  if (last_sequence_ >= 0 && info.sequence > last_sequence_ + 1) {
+    info.dropped = static_cast<uint32_t>(info.sequence - last_sequence_ - 1);
+    const uint64_t dropped_frames = dropped_frames_ += info.dropped;
+    ROS_WARN_THROTTLE(1.0, "%s dropped %u frame(s), %lu since the start.",
+                      media_->GetName().c_str(), info.dropped,
+                      static_cast<unsigned long>(dropped_frames));
+  }
+  last_sequence_ = info.sequence;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::FillHeader(const FrameInfo &info,
+                               std_msgs::Header &header) const {
+  header.stamp = info.stamp;
+  // roscpp rewrites the seq for the subscribers of other processes, only the
+  // ones in this process see the sequence of the device.
+  header.seq = static_cast<uint32_t>(info.sequence);
+  header.frame_id = config_.frame_id_;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::ConvertFrame(Frame &frame) {
+  bool result = false;
+
+  // A debayering costs a core on the bigger cameras, do not pay for it if
+  // nobody receives the color image.
+  if (IsColorNeeded()) {
+    const SteadyClock::time_point start = SteadyClock::now();
+    PrepareMessage(frame);
+    if (undistort_ && media_->CanFuseUndistortion()) {
+      // A single pass from the raw image to the undistorted one, timed as
+      // the conversion.
+      result = undistortion_.PrepareMaps(frame.raw.size()) &&
+               media_->ConvertUndistortedFrame(frame, undistortion_.GetMap1(),
+                                               undistortion_.GetMap2()) &&
+               FinalizeMessage(frame);
+      RecordLatency(Stage::CONVERSION, start);
+    } else {
+      result = media_->ConvertFrame(frame) && FinalizeMessage(frame);
+      RecordLatency(Stage::CONVERSION, start);
+      if (result && undistort_) {
+        result = UndistortFrame(frame);
+      }
+    }
+    if (result) {
+      BuildPyramid(frame);
+    } else {
+      frame.message.reset();
+      frame.image.release();
+    }
+  }
+
+  // Encoded before the raw image is released, when it is the one encoded.
+  if (IsCompressedNeeded() && EncodeFrame(frame)) {
+    result = true;
+  }
+  if (IsCompressedRawNeeded() && EncodeRawFrame(frame)) {
+    result = true;
+  }
+
+  if (IsRawNeeded()) {
+    FillRawMessage(frame);
+    result = true;
+  } else {
+    // Gives the buffer back to the pool of the media.
+    frame.raw_message.reset();
+  }
+
+  // The raw image may be a header on the raw message or on a buffer of the
+  // driver, it must not outlive them. Releasing the lease gives the buffer
+  // back to the driver.
+  frame.raw.release();
+  frame.lease.reset();
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::UndistortFrame(Frame &frame) {
+  const SteadyClock::time_point start = SteadyClock::now();
+  if (!undistortion_.PrepareMaps(frame.image.size())) {
+    return false;
+  }
+  cv::Mat undistorted;
+  sensor_msgs::ImagePtr message = pool_.Acquire(
+      frame.image.rows, frame.image.cols, frame.image.type(), undistorted);
+  if (!undistortion_.Undistort(frame.image, undistorted)) {
+    return false;
+  }
+  message->header = frame.message->header;
+  message->encoding = frame.message->encoding;
+  message->is_bigendian = frame.message->is_bigendian;
+  // The distorted image goes back to the pool.
+  frame.message = message;
+  frame.image = undistorted;
+  RecordLatency(Stage::UNDISTORTION, start);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::BuildPyramid(Frame &frame) {
+  const size_t depth = GetPyramidDepth();
+  if (depth == 0) {
+    return;
+  }
+  const SteadyClock::time_point start = SteadyClock::now();
+  frame.pyramid.assign(depth, sensor_msgs::ImagePtr());
+  cv::Mat above = frame.image;
+  for (size_t i = 0; i < depth && above.rows >= 2 && above.cols >= 2; ++i) {
+    // The levels without subscribers are computed in their pool all the
+    // same, the levels below are derived from them.
+    cv::Mat level;
+    sensor_msgs::ImagePtr message = pyramid_pools_[i]->Acquire(
+        above.rows / 2, above.cols / 2, above.type(), level);
+    if (pyramid_box_) {
+      // Neither this level nor the ones derived from it are published.
+      if (!DownsampleBox(above, level)) {
+        ROS_WARN_THROTTLE(1.0, "%s could not downsample its pyramid.",
+                          media_->GetName().c_str());
+        break;
+      }
+    } else {
+      cv::pyrDown(above, level, level.size());
+    }
+    message->header = frame.message->header;
+    message->encoding = frame.message->encoding;
+    message->is_bigendian = frame.message->is_bigendian;
+    if (pyramid_publishers_[i].getNumSubscribers() > 0) {
+      frame.pyramid[i] = message;
+    }
+    above = level;
+  }
+  RecordLatency(Stage::PYRAMID, start);
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::EncodeFrame(Frame &frame) {
+  const bool from_raw = compress_raw_ && frame.raw.type() == CV_8UC2;
+  const cv::Mat &image = from_raw ? frame.raw : frame.image;
+  if (image.empty()) {
+    return false;
+  }
+  const SteadyClock::time_point start = SteadyClock::now();
+  sensor_msgs::CompressedImagePtr message =
+      boost::make_shared<sensor_msgs::CompressedImage>();
+  if (!EncodeJpeg(image, config_.jpeg_quality_, config_.jpeg_restart_rows_,
+                  message->data)) {
+    ROS_WARN_THROTTLE(1.0, "%s could not encode its image in JPEG.",
+                      media_->GetName().c_str());
+    return false;
+  }
+  // The format of the compressed transport, for its subscribers.
+  message->format = image.type() == CV_8UC1 ? "mono8; jpeg compressed mono8"
+                                            : "bgr8; jpeg compressed bgr8";
+  FillHeader(frame.info, message->header);
+  frame.compressed = message;
+  RecordLatency(Stage::ENCODING, start);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::EncodeRawFrame(Frame &frame) {
+  if (frame.raw.type() != CV_8UC1) {
+    return false;
+  }
+  const SteadyClock::time_point start = SteadyClock::now();
+  sensor_msgs::CompressedImagePtr message =
+      boost::make_shared<sensor_msgs::CompressedImage>();
+  if (!EncodeBayer(frame.raw, bayer_codec_, config_.jpeg_quality_,
+                   config_.jpeg_restart_rows_, message->data)) {
+    ROS_WARN_THROTTLE(1.0, "%s could not compress its Bayer mosaic.",
+                      media_->GetName().c_str());
+    return false;
+  }
+  message->format = GetBayerFormat(media_->GetRawEncoding(), bayer_codec_);
+  FillHeader(frame.info, message->header);
+  frame.compressed_raw = message;
+  RecordLatency(Stage::ENCODING, start);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::PublishFrame(Frame &frame) {
+  const SteadyClock::time_point start = SteadyClock::now();
+  // The messages are not touched after this point, for the subscribers in the
+  // same process (i.e. nodelets), this is the very buffer that was converted.
+  if (frame.raw_message) {
+    raw_publisher_.publish(sensor_msgs::ImageConstPtr(frame.raw_message));
+    frame.raw_message.reset();
+  }
+  if (frame.message) {
+    // The recorder holds the message until it is encoded, nothing writes in
+    // it once published.
+    if (recorder_) {
+      recorder_->Record(frame.message);
+    }
+    image_publisher_.publish(sensor_msgs::ImageConstPtr(frame.message));
+    frame.message.reset();
+  }
+  if (frame.compressed) {
+    compressed_publisher_.publish(
+        sensor_msgs::CompressedImageConstPtr(frame.compressed));
+    frame.compressed.reset();
+  }
+  if (frame.compressed_raw) {
+    compressed_raw_publisher_.publish(
+        sensor_msgs::CompressedImageConstPtr(frame.compressed_raw));
+    frame.compressed_raw.reset();
+  }
+  for (size_t i = 0; i < frame.pyramid.size(); ++i) {
+    if (frame.pyramid[i]) {
+      pyramid_publishers_[i].publish(
+          sensor_msgs::ImageConstPtr(frame.pyramid[i]));
+    }
+  }
+  frame.pyramid.clear();
+  frame.image.release();
+  RecordLatency(Stage::PUBLISHING, start);
+  const double latency = (ros::Time::now() - frame.info.stamp).toSec();
+  capture_latency_.Record(latency);
+  StreamScheduler::Instance().ReportLatency(qos_stream_, latency);
+  ++published_frames_;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::ApplyThreadSettings() {
+  std::string report;
+  // The acquisition thread (the only one in sequential mode) is the one that
+  // must keep up with the camera.
+  const std::string &acquisition_cpus = config_.acquisition_cpu_affinity_.empty()
+                                            ? config_.cpu_affinity_
+                                            : config_.acquisition_cpu_affinity_;
+  if (!acquisition_cpus.empty() && SetThreadAffinity(thread_, acquisition_cpus)) {
+    report += " acquisition on CPUs " + acquisition_cpus + ";";
+  }
+  if (!config_.cpu_affinity_.empty() && mode_ == Mode::PIPELINED &&
+      SetThreadAffinity(conversion_thread_, config_.cpu_affinity_) &&
+      SetThreadAffinity(publishing_thread_, config_.cpu_affinity_)) {
+    report += " conversion and publishing on CPUs " + config_.cpu_affinity_ + ";";
+  }
+  if (config_.realtime_priority_ > 0 &&
+      SetThreadRealtimePriority(thread_, config_.realtime_priority_)) {
+    report += " acquisition with SCHED_FIFO priority " +
+              std::to_string(config_.realtime_priority_) + ";";
+  }
+  if (config_.lock_memory_ && LockProcessMemory()) {
+    report += " memory locked;";
+  }
+  if (report.empty()) {
+    report = " default scheduling;";
+  }
+  report.pop_back();
+  ROS_INFO("%s threads:%s", media_->GetName().c_str(), report.c_str());
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::RecordLatency(Stage stage,
+                                  const SteadyClock::time_point &start) {
+  stage_latencies_[static_cast<size_t>(stage)].Record(
+      std::chrono::duration<double>(SteadyClock::now() - start).count());
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::PublishDiagnostics(const ros::WallTimerEvent &event) {
+  (void)event;
+  const ros::WallTime now = ros::WallTime::now();
+  const double elapsed = (now - last_diagnostics_).toSec();
+  last_diagnostics_ = now;
+
+  const uint64_t published_frames = published_frames_;
+  const uint64_t dropped_frames = dropped_frames_;
+  const uint64_t queue_drops =
+      convert_queue_.DroppedCount() + publish_queue_.DroppedCount();
+  const uint64_t published = published_frames - last_published_frames_;
+  const uint64_t dropped = dropped_frames - last_dropped_frames_;
+  const uint64_t queue_dropped = queue_drops - last_queue_drops_;
+  last_published_frames_ = published_frames;
+  last_dropped_frames_ = dropped_frames;
+  last_queue_drops_ = queue_drops;
+  const double fps = elapsed > 0.0 ? published / elapsed : 0.0;
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = "provider_vision: " + media_->GetName();
+  status.hardware_id = media_->GetName();
+  char summary[128];
+  if (media_->HasArtificialFramerate() && clock_.IsPaused()) {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    snprintf(summary, sizeof(summary), "Paused");
+  } else if (published == 0 &&
+             (IsColorNeeded() || IsRawNeeded() || IsCompressedNeeded() ||
+              IsCompressedRawNeeded())) {
+    status.level = diagnostic_msgs::DiagnosticStatus::ERROR;
+    snprintf(summary, sizeof(summary), "No frame published");
+  } else if (dropped > 0 || queue_dropped > 0) {
+    status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    snprintf(summary, sizeof(summary), "%.1f fps, %lu frame(s) dropped", fps,
+             static_cast<unsigned long>(dropped + queue_dropped));
+  } else {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    snprintf(summary, sizeof(summary), "%.1f fps", fps);
+  }
+  status.message = summary;
+
+  AddValue(status, "fps", fps);
+  AddValue(status, "published frames", published_frames);
+  AddValue(status, "dropped frames (device)", dropped_frames);
+  AddValue(status, "dropped frames (convert queue)",
+           convert_queue_.DroppedCount());
+  AddValue(status, "dropped frames (publish queue)",
+           publish_queue_.DroppedCount());
+  AddValue(status, "skipped frames (qos)",
+           StreamScheduler::Instance().GetSkippedCount(qos_stream_));
+  AddValue(status, "qos share",
+           StreamScheduler::Instance().GetShare(qos_stream_));
+  if (mode_ == Mode::PIPELINED) {
+    AddValue(status, "convert queue depth",
+             static_cast<uint64_t>(convert_queue_.Size()));
+    AddValue(status, "publish queue depth",
+             static_cast<uint64_t>(publish_queue_.Size()));
+  }
+  if (recorder_) {
+    AddValue(status, "recorded frames", recorder_->GetRecordedCount());
+    AddValue(status, "dropped frames (recorder)",
+             recorder_->GetDroppedCount());
+  }
+  for (size_t i = 0; i < STAGE_COUNT; ++i) {
+    const LatencyHistogram::Summary latency =
+        stage_latencies_[i].TakeSummary();
+    // A stage that did not run (i.e. nobody subscribes to the color image)
+    // has nothing to report.
+    if (latency.count > 0) {
+      AddLatency(status, kStageNames[i], latency);
+    }
+  }
+  AddLatency(status, "capture to publish", capture_latency_.TakeSummary());
+
+  diagnostic_msgs::DiagnosticArray array;
+  array.header.stamp = ros::Time::now();
+  array.status.push_back(status);
+  diagnostics_publisher_.publish(array);
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::IsColorNeeded() const {
+  return image_publisher_.getNumSubscribers() > 0 || GetPyramidDepth() > 0 ||
+         (IsCompressedNeeded() && !compress_raw_) || recorder_ != nullptr;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t MediaStreamer::GetPyramidDepth() const {
+  for (size_t depth = pyramid_publishers_.size(); depth > 0; --depth) {
+    if (pyramid_publishers_[depth - 1].getNumSubscribers() > 0) {
+      return depth;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::IsRawNeeded() const {
+  return publish_raw_ && raw_publisher_.getNumSubscribers() > 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::IsCompressedNeeded() const {
+  return publish_compressed_ && compressed_publisher_.getNumSubscribers() > 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::IsCompressedRawNeeded() const {
+  return publish_compressed_raw_ &&
+         compressed_raw_publisher_.getNumSubscribers() > 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::FillRawMessage(Frame &frame) const {
+  // When the media acquired the frame in a buffer of its pool, this buffer is
+  // published as is.
+  if (!frame.raw_message) {
+    frame.raw_message = boost::make_shared<sensor_msgs::Image>();
+    sensor_msgs::Image &msg = *frame.raw_message;
+    msg.height = static_cast<uint32_t>(frame.raw.rows);
+    msg.width = static_cast<uint32_t>(frame.raw.cols);
+    msg.step = static_cast<uint32_t>(frame.raw.cols * frame.raw.elemSize());
+    msg.data.resize(msg.step * msg.height);
+    cv::Mat message_image(frame.raw.size(), frame.raw.type(), msg.data.data(),
+                          msg.step);
+    frame.raw.copyTo(message_image);
+  }
+  frame.raw_message->encoding = media_->GetRawEncoding();
+  frame.raw_message->is_bigendian = 0;
+  FillHeader(frame.info, frame.raw_message->header);
+}
+
+//------------------------------------------------------------------------------
+//
+void MediaStreamer::PrepareMessage(Frame &frame) {
+  if (output_type_ < 0) {
+    frame.message.reset();
+    frame.image.release();
+    return;
+  }
+  // Functions like cv::cvtColor will write in this buffer as long as the
+  // conversion produces an image of the same size and type.
+  frame.message = pool_.Acquire(output_size_.height, output_size_.width,
+                                output_type_, frame.image);
+}
+
+//------------------------------------------------------------------------------
+//
+bool MediaStreamer::FinalizeMessage(Frame &frame) {
+  if (frame.image.empty()) {
+    frame.message.reset();
+    return false;
+  }
+  if (frame.image.size() != output_size_ || frame.image.type() != output_type_) {
+    // First frame or change of geometry, the pool is filled once for all the
+    // frames to come.
+    output_size_ = frame.image.size();
+    output_type_ = frame.image.type();
+    pool_.Reserve(output_size_.height, output_size_.width, output_type_);
+  }
+
+  const bool converted_in_place =
+      frame.message && frame.image.data == frame.message->data.data() &&
+      frame.message->height == static_cast<uint32_t>(frame.image.rows) &&
+      frame.message->width == static_cast<uint32_t>(frame.image.cols);
+
+  if (!converted_in_place) {
+    // The conversion allocated its own buffer (first frame, change of
+    // geometry or a media that shares its image), copy it in the message.
+    frame.message.reset();
+    cv::Mat message_image;
+    frame.message = pool_.Acquire(frame.image.rows, frame.image.cols,
+                                  frame.image.type(), message_image);
+    frame.image.copyTo(message_image);
+    frame.image = message_image;
+  }
+  frame.message->encoding = EncodingFromType(output_type_);
+  frame.message->is_bigendian = 0;
+  FillHeader(frame.info, frame.message->header);
+  return true;
+}
+
 }  // namespace provider_vision
@@ -21,22 +21,45 @@
 #ifndef PROVIDER_VISION_MEDIA_MEDIA_STREAMER_H_
 #define PROVIDER_VISION_MEDIA_MEDIA_STREAMER_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <ros/ros.h>
-#include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.h>
+#include <sensor_msgs/image_encodings.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <lib_atlas/sys/timer.h>
+#include "provider_vision/media/cam_undistord_matrices.h"
 #include "provider_vision/media/camera/base_media.h"
+#include "provider_vision/media/camera_configuration.h"
+#include "provider_vision/media/conversion/bayer_codec.h"
+#include "provider_vision/media/frame.h"
+#include "provider_vision/media/frame_pool.h"
+#include "provider_vision/media/latency_histogram.h"
+#include "provider_vision/media/media_recorder.h"
+#include "provider_vision/media/media_clock.h"
+#include "provider_vision/media/spsc_ring.h"
+#include "provider_vision/media/stream_scheduler.h"
+#include "provider_vision/media/thread_settings.h"
 
 
 namespace provider_vision {
 
 /**
  * Class responsible of acquiring an image from a device and broadcasting it to ROS.
- * It is basically a thread running and getting images from a media.
+ *
+ * In sequential mode, it is basically a thread running and getting images
+ * from a media, converting and publishing them.
+ * In pipelined mode, the acquisition, the conversion and the publishing each
+ * run on their own thread and the frames are passed from a stage to the next
+ * through bounded SPSC rings. The frame N+1 is then acquired while the
+ * frame N is converted and the frame N-1 is published, and the throughput is
+ * the one of the slowest stage instead of the sum of all of them.
  */
 class MediaStreamer {
 public:
@@ -45,39 +68,200 @@ public:
 
   using Ptr = std::shared_ptr<MediaStreamer>;
 
+  using FrameRing = SpscRing<Frame>;
+
+  enum class Mode { SEQUENTIAL, PIPELINED };
+
+  // The stages that are timed for the diagnostics.
+  enum class Stage {
+    ACQUISITION = 0,
+    CONVERSION,
+    UNDISTORTION,
+    PYRAMID,
+    ENCODING,
+    PUBLISHING
+  };
+
+  static const size_t STAGE_COUNT = 6;
+
   //==========================================================================
   // P U B L I C   C / D T O R S
 
   /**
-   * Artificial frame rate simulate a frame rate for video and images.
-   * It will run the loop at this speed.
+   * Artificial frame rate simulate a frame rate for video and images that do
+   * not store one. The playback is paced by the media clock, see
+   * CameraConfiguration for its rate and speed.
    */
-  explicit MediaStreamer(BaseMedia::Ptr cam, ros::NodeHandle &node_handle, const std::string &topic_name,
+  explicit MediaStreamer(BaseMedia::Ptr cam, const CameraConfiguration &config,
+                         ros::NodeHandle &node_handle, const std::string &topic_name,
                          int artificialFrameRateMs = 30);
 
   virtual ~MediaStreamer();
 
   std::string GetMediaName();
 
+  Mode GetMode() const;
+
+  /**
+   * The clock pacing the playback of the images and videos, to pause, step
+   * or change the speed of the playback. It does nothing for the cameras.
+   */
+  MediaClock &GetClock();
+
 private:
   //==========================================================================
   // P R I V A T E   M E T H O D S
+
+  // Sequential mode, all the stages on the same thread.
   void BroadcastThread();
 
+  // Pipelined mode, one thread per stage.
+  void AcquisitionThread();
+  void ConversionThread();
+  void PublishingThread();
+
+  // The body of each stage, shared by both modes.
+  bool AcquireFrame(Frame &frame, atlas::MilliTimer &timer);
+  bool ConvertFrame(Frame &frame);
+  void PublishFrame(Frame &frame);
+
+  // Remaps the converted image in another message of the pool. The maps are
+  // computed (or read from the cache) on the first frame of each size.
+  bool UndistortFrame(Frame &frame);
+
+  // Halves the image down to the deepest level of the pyramid somebody
+  // subscribes to, each level from the one above it.
+  void BuildPyramid(Frame &frame);
+
+  // Encodes the JPEG of the image, or of the raw image when it is encoded
+  // as it is.
+  bool EncodeFrame(Frame &frame);
+
+  // Compresses the Bayer mosaic of the raw image.
+  bool EncodeRawFrame(Frame &frame);
+
+  // Makes the image of the frame a header on the data of a message of the
+  // pool, with the geometry of the last converted image.
+  void PrepareMessage(Frame &frame);
+
+  // Fills the message of the frame, copying the image only if the
+  // conversion could not write it in place.
+  bool FinalizeMessage(Frame &frame);
+
+  // Fills the raw message of the frame, copying the raw image only if the
+  // media did not acquire it in a message of its pool.
+  void FillRawMessage(Frame &frame) const;
+
+  // Stamps and counts the frame when the media could not, and counts the
+  // frames lost on the way. Only called by the acquisition stage.
+  void FillFrameInfo(FrameInfo &info);
+
+  void FillHeader(const FrameInfo &info, std_msgs::Header &header) const;
+
+  // Applies the affinity, priority and memory settings of the configuration
+  // to the threads and reports them.
+  void ApplyThreadSettings();
+
+  void RecordLatency(Stage stage, const std::chrono::steady_clock::time_point &start);
+
+  // Publishes the timings, the throughput and the drops since the last call
+  // on /diagnostics.
+  void PublishDiagnostics(const ros::WallTimerEvent &event);
+
+  // The conversion to BGR is skipped while nobody would receive it, nor
+  // any level of the pyramid, nor its JPEG, nor the recorder.
+  bool IsColorNeeded() const;
+
+  // The deepest level of the pyramid with a subscriber, 0 if none.
+  size_t GetPyramidDepth() const;
+
+  bool IsRawNeeded() const;
+
+  bool IsCompressedNeeded() const;
+
+  bool IsCompressedRawNeeded() const;
+
   //==========================================================================
   // P R I V A T E   M E M B E R S
 
   // Active media for the loop
   BaseMedia::Ptr media_;
-  // Flag to stop the thread
-  bool stop_thread_;
-  // The thread for broadcasting an image
+  CameraConfiguration config_;
+  Mode mode_;
+  // Flag to stop the threads
+  std::atomic<bool> stop_thread_;
+  // Frames going from the acquisition to the conversion and from the
+  // conversion to the publishing. Only used in pipelined mode.
+  FrameRing convert_queue_;
+  FrameRing publish_queue_;
+  // The thread for broadcasting an image, the acquisition thread in
+  // pipelined mode.
   std::thread thread_;
+  std::thread conversion_thread_;
+  std::thread publishing_thread_;
   // Necessary publisher for the image
   image_transport::Publisher image_publisher_;
   image_transport::ImageTransport it_;
+  // Publisher for the native buffer of the media, in raw output mode.
+  image_transport::Publisher raw_publisher_;
+  bool publish_raw_;
+  // Publisher for the JPEG images, in place of the compressed transport.
+  // The raw image is encoded when the media delivers YUV422 that is not
+  // undistorted.
+  ros::Publisher compressed_publisher_;
+  bool publish_compressed_;
+  bool compress_raw_;
+  // Publisher for the compressed Bayer mosaics.
+  ros::Publisher compressed_raw_publisher_;
+  bool publish_compressed_raw_;
+  BayerCodec bayer_codec_;
+
+  // The messages in which the images are converted. They go back to the
+  // pool once published and released by every subscriber.
+  FramePool pool_;
+
+  MediaClock clock_;
+
+  // The sequence of the last acquired frame, only accessed by the
+  // acquisition stage, and the frames lost so far.
+  int64_t last_sequence_;
+  std::atomic<uint64_t> dropped_frames_;
 
-  float frame_rate_;
+  // Each stage records its own timings, the diagnostics read them from the
+  // thread of the timer.
+  std::array<LatencyHistogram, STAGE_COUNT> stage_latencies_;
+  // From the capture of the frame to its publishing.
+  LatencyHistogram capture_latency_;
+  std::atomic<uint64_t> published_frames_;
+
+  ros::Publisher diagnostics_publisher_;
+  ros::WallTimer diagnostics_timer_;
+  ros::WallTime last_diagnostics_;
+  uint64_t last_published_frames_;
+  uint64_t last_dropped_frames_;
+  uint64_t last_queue_drops_;
+
+  // Geometry of the last converted image, only accessed by the conversion
+  // stage. A negative type means that no image has been converted yet.
+  cv::Size output_size_;
+  int output_type_;
+
+  // The calibration of the media, only used by the conversion stage once
+  // the streamer is started.
+  CameraUndistordMatrices undistortion_;
+  bool undistort_;
+
+  // A publisher and a pool of messages per level of the pyramid, the first
+  // one is half the size of the image.
+  std::vector<image_transport::Publisher> pyramid_publishers_;
+  std::vector<std::unique_ptr<FramePool>> pyramid_pools_;
+  bool pyramid_box_;
+
+  // The stream of the media in the scheduler of the process.
+  int qos_stream_;
+
+  // Records the published images in a video, if configured.
+  MediaRecorder::Ptr recorder_;
 
 };
 
@@ -85,6 +269,14 @@ inline std::string MediaStreamer::GetMediaName() {
   return media_->GetName();
 }
 
+inline MediaStreamer::Mode MediaStreamer::GetMode() const {
+  return mode_;
+}
+
+inline MediaClock &MediaStreamer::GetClock() {
+  return clock_;
+}
+
 
 }
 
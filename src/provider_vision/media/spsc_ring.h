@@ -0,0 +1,409 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_SPSC_RING_H_
+#define PROVIDER_VISION_MEDIA_SPSC_RING_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * Bounded lock-free ring for exactly one producer thread and one consumer
+ * thread.
+ *
+ * The producer only writes the tail index and the consumer only writes the
+ * head index, so no lock is needed: the acquire/release pairs on the indexes
+ * are enough to publish the slots from a thread to the other.
+ *
+ * In KEEP_LATEST mode, the ring is a triple buffer instead: the producer
+ * writes in its slot and swaps it with the middle one, the consumer swaps
+ * its slot with the middle one when it holds a value it has not taken yet.
+ *
+ * A thread that waits on the ring (for an element or for a free slot) spins
+ * a little, then sleeps on a condition variable. The other thread only
+ * takes the lock to wake it when it is flagged as waiting, so an idle stage
+ * does not wake up and a busy one does not lock.
+ */
+template <typename T>
+class SpscRing {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  /**
+   * What to do when a stage produces faster than the next one consumes.
+   *
+   * BLOCK makes the producer wait for a free slot, no frame is ever lost.
+   * DROP discards the incoming element when the ring is full.
+   * KEEP_LATEST makes the producer replace the element the consumer has not
+   * taken yet, the consumer always gets the newest one, which gives the
+   * lowest latency. The capacity does not apply then, a single element
+   * waits for the consumer.
+   */
+  enum class DropPolicy { BLOCK, DROP, KEEP_LATEST };
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit SpscRing(size_t capacity);
+
+  ~SpscRing() = default;
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * Producer side. Returns false if the ring is full, the value is then left
+   * untouched. In KEEP_LATEST mode, it is never full.
+   */
+  bool TryPush(T &value);
+
+  /**
+   * Consumer side. Returns false if the ring is empty.
+   */
+  bool TryPop(T &value);
+
+  /**
+   * Producer side. Applies the drop policy of the ring, waiting for a free
+   * slot in BLOCK mode as long as stop is not set. A stop is noticed within
+   * 100 ms.
+   *
+   * \return True if the value has been queued, false if it has been dropped.
+   */
+  bool Push(T &value, const std::atomic<bool> &stop);
+
+  /**
+   * Consumer side. Waits for an element as long as stop is not set. A stop
+   * is noticed within 100 ms.
+   *
+   * \return True if an element has been popped.
+   */
+  bool Pop(T &value, const std::atomic<bool> &stop);
+
+  void SetDropPolicy(DropPolicy policy);
+
+  DropPolicy GetDropPolicy() const;
+
+  size_t Size() const;
+
+  size_t Capacity() const;
+
+  /**
+   * The number of elements that has been discarded by the drop policy since
+   * the creation of the ring.
+   */
+  uint64_t DroppedCount() const;
+
+  static DropPolicy ParseDropPolicy(const std::string &name);
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  // Spins for the first attempts, then sleeps until ready returns true or
+  // stop is set.
+  template <typename Ready>
+  void Backoff(int &attempt, Ready ready, const std::atomic<bool> &stop);
+
+  // Wakes the other thread if it sleeps in Backoff.
+  void Notify();
+
+  // The triple buffer of the KEEP_LATEST mode.
+  void PushLatest(T &value);
+  bool TryPopLatest(T &value);
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  std::vector<T> buffer_;
+
+  size_t capacity_;
+
+  DropPolicy policy_;
+
+  // Both indexes only grow, the slot is the index modulo the capacity.
+  // They are kept on their own cache line so the producer and the consumer
+  // do not invalidate each other.
+  alignas(64) std::atomic<size_t> head_;
+
+  alignas(64) std::atomic<size_t> tail_;
+
+  alignas(64) std::atomic<uint64_t> dropped_;
+
+  // The threads sleeping in Backoff. The stop flag is not signaled, a
+  // sleeping thread checks it at least every kStopPollPeriod.
+  alignas(64) std::atomic<int> waiters_;
+  std::mutex wait_access_;
+  std::condition_variable wait_ready_;
+
+  // The slots of the KEEP_LATEST mode. The producer owns the back one, the
+  // consumer the front one. The middle one is exchanged between them, with
+  // the kFreshLatest bit set when it holds a value the consumer has not
+  // taken yet.
+  static const unsigned kFreshLatest = 4;
+  static const unsigned kLatestIndexMask = 3;
+
+  std::array<T, 3> latest_;
+
+  unsigned latest_back_;
+
+  alignas(64) std::atomic<unsigned> latest_middle_;
+
+  alignas(64) unsigned latest_front_;
+};
+
+//==============================================================================
+// I N L I N E   F U N C T I O N S   D E F I N I T I O N S
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline SpscRing<T>::SpscRing(size_t capacity)
+    : buffer_(capacity > 0 ? capacity : 1),
+      capacity_(capacity > 0 ? capacity : 1),
+      policy_(DropPolicy::BLOCK),
+      head_(0),
+      tail_(0),
+      dropped_(0),
+      waiters_(0),
+      wait_access_(),
+      wait_ready_(),
+      latest_(),
+      latest_back_(0),
+      latest_middle_(1),
+      latest_front_(2) {}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline bool SpscRing<T>::TryPush(T &value) {
+  if (policy_ == DropPolicy::KEEP_LATEST) {
+    PushLatest(value);
+    Notify();
+    return true;
+  }
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+    return false;
+  }
+  buffer_[tail % capacity_] = std::move(value);
+  tail_.store(tail + 1, std::memory_order_release);
+  Notify();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline bool SpscRing<T>::TryPop(T &value) {
+  if (policy_ == DropPolicy::KEEP_LATEST) {
+    // Nothing waits for a free slot in this mode.
+    return TryPopLatest(value);
+  }
+  const size_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  // Moving out of the slot releases whatever it was holding (i.e. the
+  // image buffers) as soon as it is consumed.
+  value = std::move(buffer_[head % capacity_]);
+  buffer_[head % capacity_] = T();
+  head_.store(head + 1, std::memory_order_release);
+  Notify();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline bool SpscRing<T>::Push(T &value, const std::atomic<bool> &stop) {
+  if (TryPush(value)) {
+    return true;
+  }
+  if (policy_ != DropPolicy::BLOCK) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  int attempt = 0;
+  while (!stop) {
+    if (TryPush(value)) {
+      return true;
+    }
+    Backoff(attempt, [this]() { return Size() < capacity_; }, stop);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline bool SpscRing<T>::Pop(T &value, const std::atomic<bool> &stop) {
+  int attempt = 0;
+  while (!TryPop(value)) {
+    if (stop) {
+      return false;
+    }
+    Backoff(attempt, [this]() { return Size() > 0; }, stop);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline void SpscRing<T>::PushLatest(T &value) {
+  latest_[latest_back_] = std::move(value);
+  const unsigned previous = latest_middle_.exchange(
+      latest_back_ | kFreshLatest, std::memory_order_acq_rel);
+  latest_back_ = previous & kLatestIndexMask;
+  if (previous & kFreshLatest) {
+    // The consumer never took it, it is released right away.
+    latest_[latest_back_] = T();
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline bool SpscRing<T>::TryPopLatest(T &value) {
+  // Only the consumer clears the bit, the middle slot stays fresh until the
+  // exchange below.
+  if (!(latest_middle_.load(std::memory_order_relaxed) & kFreshLatest)) {
+    return false;
+  }
+  const unsigned previous =
+      latest_middle_.exchange(latest_front_, std::memory_order_acq_rel);
+  latest_front_ = previous & kLatestIndexMask;
+  value = std::move(latest_[latest_front_]);
+  latest_[latest_front_] = T();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline void SpscRing<T>::SetDropPolicy(DropPolicy policy) {
+  policy_ = policy;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline typename SpscRing<T>::DropPolicy SpscRing<T>::GetDropPolicy() const {
+  return policy_;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline size_t SpscRing<T>::Size() const {
+  if (policy_ == DropPolicy::KEEP_LATEST) {
+    return (latest_middle_.load(std::memory_order_acquire) & kFreshLatest) ? 1
+                                                                           : 0;
+  }
+  return tail_.load(std::memory_order_acquire) -
+         head_.load(std::memory_order_acquire);
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline size_t SpscRing<T>::Capacity() const {
+  return capacity_;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline uint64_t SpscRing<T>::DroppedCount() const {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline typename SpscRing<T>::DropPolicy SpscRing<T>::ParseDropPolicy(
+    const std::string &name) {
+  if (name == "drop") {
+    return DropPolicy::DROP;
+  } else if (name == "keep_latest") {
+    return DropPolicy::KEEP_LATEST;
+  }
+  return DropPolicy::BLOCK;
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+template <typename Ready>
+inline void SpscRing<T>::Backoff(int &attempt, Ready ready,
+                                 const std::atomic<bool> &stop) {
+  // Spinning a little is cheaper than going to sleep when the other stage is
+  // about to deliver, but we do not want to burn a core on an idle camera.
+  if (attempt < 64) {
+    ++attempt;
+    std::this_thread::yield();
+    return;
+  }
+  const std::chrono::milliseconds kStopPollPeriod(100);
+  // Flagged before the last check, either this check sees the element (or
+  // the slot) or the other thread sees the flag and wakes this one up.
+  waiters_.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  {
+    std::unique_lock<std::mutex> lock(wait_access_);
+    while (!ready() && !stop) {
+      wait_ready_.wait_for(lock, kStopPollPeriod);
+    }
+  }
+  waiters_.fetch_sub(1);
+}
+
+//------------------------------------------------------------------------------
+//
+template <typename T>
+inline void SpscRing<T>::Notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load(std::memory_order_relaxed) > 0) {
+    // Taking the lock makes sure the waiter is either before its check or
+    // already waiting.
+    { std::lock_guard<std::mutex> guard(wait_access_); }
+    wait_ready_.notify_all();
+  }
+}
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_SPSC_RING_H_
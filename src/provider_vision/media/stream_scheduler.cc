@@ -0,0 +1,230 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/stream_scheduler.h"
+#include <ros/ros.h>
+#include <algorithm>
+#include <climits>
+
+namespace provider_vision {
+
+namespace {
+
+// The smallest share of a throttled stream, its minimal rate applies anyway.
+const double kMinShare = 1.0 / 32.0;
+
+// The share given back to a throttled stream per period without a late
+// stream.
+const double kRecoveryStep = 0.1;
+
+double ToSeconds(StreamScheduler::Clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+StreamScheduler::StreamScheduler(Clock::duration adjustment_period)
+    : mutex_(),
+      streams_(),
+      next_stream_(0),
+      adjustment_period_(adjustment_period),
+      last_adjustment_() {}
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+StreamScheduler &StreamScheduler::Instance() {
+  static StreamScheduler scheduler;
+  return scheduler;
+}
+
+//------------------------------------------------------------------------------
+//
+int StreamScheduler::Register(const std::string &name, const Policy &policy) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Stream stream;
+  stream.name = name;
+  stream.policy = policy;
+  stream.share = 1.0;
+  stream.arrival_period = 0.0;
+  stream.started = false;
+  stream.skipped = 0;
+  stream.late = false;
+  streams_[next_stream_] = stream;
+  return next_stream_++;
+}
+
+//------------------------------------------------------------------------------
+//
+void StreamScheduler::Unregister(int stream) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  streams_.erase(stream);
+}
+
+//------------------------------------------------------------------------------
+//
+bool StreamScheduler::Admit(int stream, Clock::time_point now) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = streams_.find(stream);
+  if (it == streams_.end()) {
+    return true;
+  }
+  Stream &s = it->second;
+
+  if (s.started) {
+    const double period = ToSeconds(now - s.last_arrival);
+    s.arrival_period = s.arrival_period > 0.0
+                           ? 0.9 * s.arrival_period + 0.1 * period
+                           : period;
+  }
+  s.last_arrival = now;
+  Adjust(now);
+
+  // The rate of the media when it is below the target one, or without a
+  // target.
+  double rate = s.arrival_period > 0.0 ? 1.0 / s.arrival_period : 0.0;
+  if (s.policy.target_fps > 0.0 && (rate <= 0.0 || s.policy.target_fps < rate)) {
+    rate = s.policy.target_fps;
+  }
+  if (s.share < 1.0) {
+    rate = std::max(rate * s.share, std::min(s.policy.min_fps, rate));
+  } else if (s.policy.target_fps <= 0.0) {
+    rate = 0.0;
+  }
+  if (rate <= 0.0) {
+    s.started = true;
+    return true;
+  }
+
+  // The frames are due one period after the other, a frame is admitted up
+  // to half a period early so the jitter of the media does not skip it. On
+  // average, the rate is the one of the deadlines.
+  const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / rate));
+  if (s.started && now < s.next_due - period / 2) {
+    ++s.skipped;
+    return false;
+  }
+  if (s.started && now - s.next_due < period) {
+    s.next_due += period;
+  } else {
+    // First frame, or the media paused, the deadlines start over.
+    s.next_due = now + period;
+  }
+  s.started = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void StreamScheduler::ReportLatency(int stream, double latency) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = streams_.find(stream);
+  if (it == streams_.end()) {
+    return;
+  }
+  const double deadline = GetDeadline(it->second);
+  if (deadline > 0.0 && latency > deadline) {
+    it->second.late = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+double StreamScheduler::GetShare(int stream) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = streams_.find(stream);
+  return it != streams_.end() ? it->second.share : 1.0;
+}
+
+//------------------------------------------------------------------------------
+//
+uint64_t StreamScheduler::GetSkippedCount(int stream) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = streams_.find(stream);
+  return it != streams_.end() ? it->second.skipped : 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void StreamScheduler::Adjust(Clock::time_point now) {
+  if (now - last_adjustment_ < adjustment_period_) {
+    return;
+  }
+  last_adjustment_ = now;
+
+  int late_priority = INT_MIN;
+  std::string late_name;
+  for (auto &entry : streams_) {
+    Stream &s = entry.second;
+    if (s.late && s.policy.priority > late_priority) {
+      late_priority = s.policy.priority;
+      late_name = s.name;
+    }
+    s.late = false;
+  }
+
+  if (late_priority != INT_MIN) {
+    for (auto &entry : streams_) {
+      Stream &s = entry.second;
+      if (s.policy.priority < late_priority && s.share > kMinShare) {
+        s.share = std::max(s.share / 2.0, kMinShare);
+        ROS_WARN_THROTTLE(5.0, "%s misses its deadline, %s is throttled to "
+                          "%.0f%% of its rate.",
+                          late_name.c_str(), s.name.c_str(), s.share * 1e2);
+      }
+    }
+    return;
+  }
+
+  // The most important streams get their rate back first.
+  int throttled_priority = INT_MIN;
+  for (const auto &entry : streams_) {
+    if (entry.second.share < 1.0) {
+      throttled_priority =
+          std::max(throttled_priority, entry.second.policy.priority);
+    }
+  }
+  for (auto &entry : streams_) {
+    Stream &s = entry.second;
+    if (s.share < 1.0 && s.policy.priority == throttled_priority) {
+      s.share = std::min(s.share + kRecoveryStep, 1.0);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+double StreamScheduler::GetDeadline(const Stream &stream) {
+  if (stream.policy.max_latency > 0.0) {
+    return stream.policy.max_latency;
+  }
+  return stream.policy.target_fps > 0.0 ? 1.0 / stream.policy.target_fps
+                                        : 0.0;
+}
+
+}  // namespace provider_vision
@@ -0,0 +1,161 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_STREAM_SCHEDULER_H_
+#define PROVIDER_VISION_MEDIA_STREAM_SCHEDULER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace provider_vision {
+
+/**
+ * Decides which frames of the streamers of the process are converted and
+ * published, so the important cameras keep their deadline when the CPU
+ * cannot keep up with all of them.
+ *
+ * Each stream has a priority, a target frame rate and a deadline, the
+ * longest a frame may take from its capture to its publishing. The frames
+ * are admitted at the target rate, the others are skipped before their
+ * conversion.
+ *
+ * A stream that misses its deadline is late because of the load of the
+ * others: the streams of a lower priority then get half of their rate,
+ * down to their minimal rate, once per adjustment period. When no stream
+ * missed its deadline for a period, the most important of the throttled
+ * streams gets a part of its rate back.
+ */
+class StreamScheduler {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<StreamScheduler>;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Policy {
+    // The higher, the more important.
+    int priority;
+    // The frames per second to publish, 0 publishes every frame of the
+    // media.
+    double target_fps;
+    // The rate a throttled stream keeps.
+    double min_fps;
+    // Seconds from the capture to the publishing, 0 is the period of the
+    // target rate. A stream without a deadline never throttles the others.
+    double max_latency;
+
+    Policy()
+        : priority(0), target_fps(0.0), min_fps(1.0), max_latency(0.0) {}
+  };
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit StreamScheduler(
+      Clock::duration adjustment_period = std::chrono::milliseconds(500));
+
+  ~StreamScheduler() = default;
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * The scheduler of the process, shared by all the streamers.
+   */
+  static StreamScheduler &Instance();
+
+  /**
+   * \return The identifier of the stream for the other methods.
+   */
+  int Register(const std::string &name, const Policy &policy);
+
+  void Unregister(int stream);
+
+  /**
+   * Called for every frame of the stream as it is acquired.
+   *
+   * \return False if the frame must be skipped.
+   */
+  bool Admit(int stream, Clock::time_point now = Clock::now());
+
+  /**
+   * Called for every published frame of the stream, with the seconds since
+   * its capture.
+   */
+  void ReportLatency(int stream, double latency);
+
+  /**
+   * The part of its rate the stream gets, 1 when it is not throttled.
+   */
+  double GetShare(int stream) const;
+
+  uint64_t GetSkippedCount(int stream) const;
+
+ private:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  struct Stream {
+    std::string name;
+    Policy policy;
+    double share;
+    // Mean period between two frames of the media, in seconds.
+    double arrival_period;
+    Clock::time_point last_arrival;
+    // When the next frame is due, at the admitted rate.
+    Clock::time_point next_due;
+    bool started;
+    uint64_t skipped;
+    // Missed its deadline since the last adjustment.
+    bool late;
+  };
+
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  // Throttles or restores the streams once per period. The lock must be
+  // held.
+  void Adjust(Clock::time_point now);
+
+  static double GetDeadline(const Stream &stream);
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  mutable std::mutex mutex_;
+
+  std::map<int, Stream> streams_;
+
+  int next_stream_;
+
+  Clock::duration adjustment_period_;
+
+  Clock::time_point last_adjustment_;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_STREAM_SCHEDULER_H_
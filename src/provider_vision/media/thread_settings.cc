@@ -0,0 +1,139 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/thread_settings.h"
+#include <pthread.h>
+#include <ros/ros.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
+namespace provider_vision {
+
+//------------------------------------------------------------------------------
+//
+bool ParseCpuSet(const std::string &cpus, cpu_set_t &set) {
+  CPU_ZERO(&set);
+
+  if (cpus.compare(0, 2, "0x") == 0 || cpus.compare(0, 2, "0X") == 0) {
+    char *end = nullptr;
+    const unsigned long long mask = std::strtoull(cpus.c_str(), &end, 16);
+    if (cpus.size() == 2 || *end != '\0') {
+      return false;
+    }
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (mask & (1ULL << cpu)) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    return true;
+  }
+
+  std::stringstream ss(cpus);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    int first = 0, last = 0;
+    char *end = nullptr;
+    first = static_cast<int>(std::strtol(range.c_str(), &end, 10));
+    if (end == range.c_str()) {
+      return false;
+    }
+    last = first;
+    if (*end == '-') {
+      const char *start = end + 1;
+      last = static_cast<int>(std::strtol(start, &end, 10));
+      if (end == start) {
+        return false;
+      }
+    }
+    if (*end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SetThreadAffinity(std::thread &thread, const std::string &cpus) {
+  cpu_set_t set;
+  if (!ParseCpuSet(cpus, set) || CPU_COUNT(&set) == 0) {
+    ROS_ERROR("Invalid CPU set: %s", cpus.c_str());
+    return false;
+  }
+  const int error =
+      pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+  if (error != 0) {
+    ROS_ERROR("Could not pin the thread on the CPUs %s: %s", cpus.c_str(),
+              strerror(error));
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool SetThreadRealtimePriority(std::thread &thread, int priority) {
+  const int min = sched_get_priority_min(SCHED_FIFO);
+  const int max = sched_get_priority_max(SCHED_FIFO);
+  if (priority < min || priority > max) {
+    ROS_ERROR("Invalid real-time priority %d, it goes from %d to %d.",
+              priority, min, max);
+    return false;
+  }
+  sched_param param;
+  param.sched_priority = priority;
+  const int error =
+      pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+  if (error != 0) {
+    ROS_ERROR("Could not set the SCHED_FIFO priority %d: %s (check the rtprio "
+              "limit of the user)",
+              priority, strerror(error));
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+bool LockProcessMemory() {
+  static std::mutex lock_access;
+  static bool locked = false;
+
+  std::lock_guard<std::mutex> guard(lock_access);
+  if (!locked) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      ROS_ERROR("Could not lock the memory of the process: %s (check the "
+                "memlock limit of the user)",
+                strerror(errno));
+      return false;
+    }
+    locked = true;
+  }
+  return true;
+}
+
+}  // namespace provider_vision
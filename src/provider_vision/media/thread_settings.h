@@ -0,0 +1,58 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_THREAD_SETTINGS_H_
+#define PROVIDER_VISION_MEDIA_THREAD_SETTINGS_H_
+
+#include <sched.h>
+#include <string>
+#include <thread>
+
+namespace provider_vision {
+
+/**
+ * Parses a set of CPUs, either as a list ("0,2-3") or as a hexadecimal mask
+ * ("0xD"). An empty string is an empty set.
+ *
+ * \return False if the string is not a valid set.
+ */
+bool ParseCpuSet(const std::string &cpus, cpu_set_t &set);
+
+/**
+ * Pins the thread on the given CPUs (see ParseCpuSet).
+ */
+bool SetThreadAffinity(std::thread &thread, const std::string &cpus);
+
+/**
+ * Schedules the thread with SCHED_FIFO at the given priority (1 to 99).
+ * It usually needs the rtprio limit of the user or CAP_SYS_NICE.
+ */
+bool SetThreadRealtimePriority(std::thread &thread, int priority);
+
+/**
+ * Locks the current and future memory of the process in RAM, so the frame
+ * buffers never fault. It applies to the whole process and is only done
+ * once. It usually needs the memlock limit of the user or CAP_IPC_LOCK.
+ */
+bool LockProcessMemory();
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_THREAD_SETTINGS_H_
@@ -0,0 +1,196 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/media/work_pool.h"
+#include <algorithm>
+
+namespace provider_vision {
+
+//==============================================================================
+// C / D T O R S   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+WorkPool::WorkPool(size_t thread_count)
+    : mutex_(),
+      job_submitted_(),
+      job_released_(),
+      jobs_(),
+      threads_(),
+      stop_(false) {
+  StartThreads(thread_count);
+}
+
+//------------------------------------------------------------------------------
+//
+WorkPool::~WorkPool() { StopThreads(); }
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+WorkPool &WorkPool::Instance() {
+  static WorkPool pool(
+      std::max(std::thread::hardware_concurrency(), 1u) - 1);
+  return pool;
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::ParallelFor(const cv::Range &range,
+                           const cv::ParallelLoopBody &body, int band_rows) {
+  const int rows = range.end - range.start;
+  if (rows <= 0) {
+    return;
+  }
+  if (band_rows <= 0) {
+    // A few bands per thread, so a thread that starts late or is preempted
+    // leaves its share to the others.
+    const int bands = 4 * static_cast<int>(GetThreadCount() + 1);
+    band_rows = std::max((rows + bands - 1) / bands, 1);
+  }
+
+  Job job;
+  job.body = &body;
+  job.begin = range.start;
+  job.end = range.end;
+  job.band_rows = band_rows;
+  job.band_count = (rows + band_rows - 1) / band_rows;
+  job.next_band = 0;
+  job.pending_bands = job.band_count;
+  job.workers = 0;
+
+  if (job.band_count > 1) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!threads_.empty()) {
+      jobs_.push_back(&job);
+      job_submitted_.notify_all();
+    }
+  }
+
+  RunBands(job);
+
+  // Every band is claimed, the job is retired and the bands still running
+  // on the threads of the pool are waited for.
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+  if (it != jobs_.end()) {
+    jobs_.erase(it);
+  }
+  job_released_.wait(lock, [&job]() {
+    return job.workers == 0 && job.pending_bands == 0;
+  });
+  lock.unlock();
+
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::SetThreadCount(size_t thread_count) {
+  StopThreads();
+  StartThreads(thread_count);
+}
+
+//------------------------------------------------------------------------------
+//
+size_t WorkPool::GetThreadCount() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return threads_.size();
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::WorkerThread() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    job_submitted_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    if (stop_) {
+      return;
+    }
+    Job &job = *jobs_.front();
+    ++job.workers;
+    lock.unlock();
+
+    RunBands(job);
+
+    lock.lock();
+    // The job has no band left to claim, the next thread looks at the next
+    // job.
+    if (!jobs_.empty() && jobs_.front() == &job) {
+      jobs_.pop_front();
+    }
+    --job.workers;
+    job_released_.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::RunBands(Job &job) {
+  int band;
+  while ((band = job.next_band.fetch_add(1)) < job.band_count) {
+    const int begin = job.begin + band * job.band_rows;
+    const int end = std::min(begin + job.band_rows, job.end);
+    try {
+      (*job.body)(cv::Range(begin, end));
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!job.error) {
+        job.error = std::current_exception();
+      }
+    }
+    if (--job.pending_bands == 0) {
+      // The thread that submitted the job may be waiting on this band.
+      std::lock_guard<std::mutex> guard(mutex_);
+      job_released_.notify_all();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::StartThreads(size_t thread_count) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  stop_ = false;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.push_back(std::thread(&WorkPool::WorkerThread, this));
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+void WorkPool::StopThreads() {
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+    threads.swap(threads_);
+  }
+  job_submitted_.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace provider_vision
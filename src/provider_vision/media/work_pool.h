@@ -0,0 +1,142 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_MEDIA_WORK_POOL_H_
+#define PROVIDER_VISION_MEDIA_WORK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <opencv2/core/core.hpp>
+#include <thread>
+#include <vector>
+
+namespace provider_vision {
+
+/**
+ * Pool of threads shared by every streamer of the process, for the work on
+ * the pixels of a frame (conversion, undistortion, ...).
+ *
+ * A job is a range of rows split in bands. The thread that submits it works
+ * on its bands, and every idle thread of the pool steals bands from the
+ * oldest job that has some left. A frame of a camera is then converted by
+ * as many cores as are idle, and the frames of several cameras converted at
+ * the same time share the cores instead of waiting for each other.
+ *
+ * The bands are claimed with an atomic counter, the lock is only taken to
+ * submit and retire a job.
+ */
+class WorkPool {
+ public:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  using Ptr = std::shared_ptr<WorkPool>;
+
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  explicit WorkPool(size_t thread_count);
+
+  ~WorkPool();
+
+  //==========================================================================
+  // P U B L I C   M E T H O D S
+
+  /**
+   * The pool of the process. It starts with a thread less than the CPUs,
+   * the thread submitting a job is the last one.
+   */
+  static WorkPool &Instance();
+
+  /**
+   * Runs the body on every band of the range and returns once all of them
+   * are done. The bands have the given number of rows, 0 splits the range
+   * in a few bands per thread. An exception thrown by the body is thrown
+   * back here, after the bands already claimed are done.
+   *
+   * A body can submit a job of its own, the thread waiting on it works on
+   * its bands in the meantime.
+   */
+  void ParallelFor(const cv::Range &range, const cv::ParallelLoopBody &body,
+                   int band_rows = 0);
+
+  /**
+   * Stops the threads and starts the given number of them. The jobs in
+   * progress are completed by the threads that submitted them.
+   */
+  void SetThreadCount(size_t thread_count);
+
+  size_t GetThreadCount() const;
+
+ private:
+  //==========================================================================
+  // T Y P E D E F   A N D   E N U M
+
+  struct Job {
+    const cv::ParallelLoopBody *body;
+    int begin;
+    int end;
+    int band_rows;
+    int band_count;
+    // The next band to claim, and the bands not done yet.
+    std::atomic<int> next_band;
+    std::atomic<int> pending_bands;
+    // The threads of the pool working on the job, it lives on the stack of
+    // the thread that submitted it and must outlive them.
+    int workers;
+    std::exception_ptr error;
+  };
+
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  void WorkerThread();
+
+  // Runs bands of the job until there is none left to claim.
+  void RunBands(Job &job);
+
+  void StartThreads(size_t thread_count);
+
+  void StopThreads();
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  mutable std::mutex mutex_;
+
+  std::condition_variable job_submitted_;
+
+  std::condition_variable job_released_;
+
+  // The jobs with bands left to claim, the oldest first.
+  std::deque<Job *> jobs_;
+
+  std::vector<std::thread> threads_;
+
+  bool stop_;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_MEDIA_WORK_POOL_H_
@@ -19,14 +19,46 @@
 /// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
 
 #include "provider_vision/server/media_manager.h"
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <utility>
+#include <boost/make_shared.hpp>
 #include "provider_vision/media/context/dc1394_context.h"
 #include "provider_vision/media/context/gige_context.h"
 #include "provider_vision/media/context/file_context.h"
 #include "provider_vision/media/context/webcam_context.h"
 #include "provider_vision/media/camera/base_media.h"
+#include "provider_vision/media/work_pool.h"
 
 namespace provider_vision {
 
+namespace {
+
+// The context whose queue the current thread is serving, if any.
+thread_local const BaseContext *current_context = nullptr;
+
+// Executes a task posted on the queue of a context.
+class ContextTask : public ros::CallbackInterface {
+ public:
+  ContextTask(const BaseContext *context,
+              std::shared_ptr<std::packaged_task<bool()>> task)
+      : context_(context), task_(std::move(task)) {}
+
+  CallResult call() override {
+    current_context = context_;
+    (*task_)();
+    current_context = nullptr;
+    return Success;
+  }
+
+ private:
+  const BaseContext *context_;
+  std::shared_ptr<std::packaged_task<bool()>> task_;
+};
+
+}  // namespace
+
 //==============================================================================
 // C / D T O R S   S E C T I O N
 
@@ -36,6 +68,15 @@ MediaManager::MediaManager(ros::NodeHandle &nh) noexcept
     : nh_(nh),
       contexts_(){
 
+  // The threads converting the frames of all the cameras, along with the
+  // threads of the streamers. One less than the CPUs by default.
+  auto work_pool_threads = -1;
+  nh_.getParam("/provider_vision/work_pool_threads", work_pool_threads);
+  if (work_pool_threads >= 0) {
+    WorkPool::Instance().SetThreadCount(
+        static_cast<size_t>(work_pool_threads));
+  }
+
   // Creating the Webcam context
   auto active_webcam = false;
   nh_.getParam("/provider_vision/active_webcam", active_webcam);
@@ -76,6 +117,14 @@ MediaManager::MediaManager(ros::NodeHandle &nh) noexcept
   // Creating the files context
   contexts_.push_back(std::make_shared<FileContext>());
 
+  for (size_t i = 0; i < contexts_.size(); ++i) {
+    auto queue = std::make_shared<ros::CallbackQueue>();
+    auto spinner = std::make_shared<ros::AsyncSpinner>(1, queue.get());
+    spinner->start();
+    context_queues_.push_back(queue);
+    context_spinners_.push_back(spinner);
+  }
+
 
   // Setting the callbacks
   server_.setCallback(boost::bind(&MediaManager::CallBackDynamicReconfigure, this, _1, _2));
@@ -84,11 +133,28 @@ MediaManager::MediaManager(ros::NodeHandle &nh) noexcept
   start_stop_media_ = nh_.advertiseService(kRosNodeName + "start_stop_camera", &MediaManager::StartStopMediaCallback, this);
   set_camera_feature_= nh_.advertiseService(kRosNodeName + "set_camera_feature", &MediaManager::SetCameraFeatureCallback, this);
   get_camera_feature_ = nh_.advertiseService(kRosNodeName + "get_camera_feature", &MediaManager::GetCameraFeatureCallback, this);
+  set_playback_ = nh_.advertiseService(kRosNodeName + "set_playback", &MediaManager::SetPlaybackCallback, this);
 }
 
 //------------------------------------------------------------------------------
 //
 MediaManager::~MediaManager() {
+  // The streamers must be stopped before their media are closed, when the
+  // nodelet is unloaded they would still be reading from a closed camera.
+  {
+    std::lock_guard<std::mutex> guard(streamers_access_);
+    media_streamers_.clear();
+  }
+  // Nothing may run on a context once it is closed. The tasks still queued
+  // are destroyed, which releases the service calls waiting on them.
+  for (auto &spinner : context_spinners_) {
+    spinner->stop();
+  }
+  for (auto &queue : context_queues_) {
+    queue->clear();
+  }
+  context_spinners_.clear();
+  context_queues_.clear();
   for (auto &elem : contexts_) {
     elem->CloseContext();
   }
@@ -130,7 +196,10 @@ bool MediaManager::SetCameraFeature(const std::string &media_name,
                                     const boost::any &value) {
   BaseContext::Ptr context = GetContextFromMedia(media_name);
   if (context) {
-    return context->SetFeature(GetFeatureFromName(feature), media_name, value);
+    return RunOnContext(context, [&]() {
+      return context->SetFeature(GetFeatureFromName(feature), media_name,
+                                 value);
+    });
   } else {
     ROS_INFO("MediaManager: Context not found for this media");
     return false;
@@ -144,7 +213,10 @@ bool MediaManager::GetCameraFeature(const std::string &media_name,
                                     boost::any &value) const {
   BaseContext::Ptr context = GetContextFromMedia(media_name);
   if (context) {
-    return context->GetFeature(GetFeatureFromName(feature), media_name, value);
+    return RunOnContext(context, [&]() {
+      return context->GetFeature(GetFeatureFromName(feature), media_name,
+                                 value);
+    });
   } else {
     ROS_INFO("MediaManager: Context not found for this media");
     return false;
@@ -406,6 +478,30 @@ void MediaManager::UpdateIfChanged(std::string camera_name,
   }
 }
 
+//------------------------------------------------------------------------------
+//
+bool MediaManager::RunOnContext(const BaseContext::Ptr &context,
+                                const std::function<bool()> &work) const {
+  for (size_t i = 0; context && i < contexts_.size(); ++i) {
+    if (contexts_[i] != context || current_context == context.get()) {
+      continue;
+    }
+    auto task = std::make_shared<std::packaged_task<bool()>>(work);
+    std::future<bool> result = task->get_future();
+    // The queue holds the only reference to the task: if it is cleared
+    // before the task runs, the promise is broken instead of never set.
+    context_queues_[i]->addCallback(
+        boost::make_shared<ContextTask>(context.get(), std::move(task)));
+    try {
+      return result.get();
+    } catch (std::future_error &e) {
+      ROS_ERROR("The context stopped before the request could run on it.");
+      return false;
+    }
+  }
+  return work();
+}
+
 bool MediaManager::IsContextValid(const std::string &name) {
   for (auto &elem : contexts_) {
     if (elem->ContainsMedia(name)) {
@@ -428,13 +524,16 @@ bool MediaManager::StartStopMediaCallback(
     provider_vision::start_stop_mediaResponse &response)
 {
   // This function need to be cleaned.
+  BaseContext::Ptr context = GetContextFromMedia(request.camera_name);
   if( request.action == request.START)
   {
-    response.action_accomplished = (uint8_t)StartStreaming(request.camera_name);
+    response.action_accomplished = (uint8_t)RunOnContext(
+        context, [&]() { return StartStreaming(request.camera_name); });
 
   }else if (request.action == request.STOP)
   {
-    response.action_accomplished = (uint8_t)StopStreaming(request.camera_name);
+    response.action_accomplished = (uint8_t)RunOnContext(
+        context, [&]() { return StopStreaming(request.camera_name); });
   }else
   {
     ROS_ERROR("Action is neither stop or start. Cannot proceed.");
@@ -487,7 +586,8 @@ bool MediaManager::StartStreaming(const std::string &media_name) {// If the medi
   context->StartStreamingMedia(media_name);
   std::string new_name = FormatNameForTopic(media_name);
 
-  auto streamer = std::make_shared<MediaStreamer>(media, nh_, kRosNodeName + new_name, 30);
+  CameraConfiguration config(nh_, FormatNameForParameter(media_name));
+  auto streamer = std::make_shared<MediaStreamer>(media, config, nh_, kRosNodeName + new_name, 30);
   if (!streamer) {
     ROS_ERROR("Streamer failed to be created");
     return action_accomplished;
@@ -508,6 +608,16 @@ std::string MediaManager::FormatNameForTopic(const std::string &media_name) cons
   return new_name;
 }
 
+std::string MediaManager::FormatNameForParameter(const std::string &media_name) const {
+  // The cameras are configured with their name as a prefix. A file path is
+  // not a valid parameter name though, so every invalid character is
+  // replaced, the file medias will simply use the default configuration.
+  std::string new_name = media_name;
+  std::replace_if(new_name.begin(), new_name.end(),
+                  [](char c) { return !std::isalnum(c) && c != '_'; }, '_');
+  return new_name;
+}
+
 //------------------------------------------------------------------------------
 //
 bool MediaManager::GetCameraFeatureCallback(
@@ -555,4 +665,39 @@ bool MediaManager::SetCameraFeatureCallback(
   return true;
 }
 
+//------------------------------------------------------------------------------
+//
+bool MediaManager::SetPlaybackCallback(
+    provider_vision::set_playback::Request &rqst,
+    provider_vision::set_playback::Response &rep) {
+  rep.action_accomplished = false;
+  MediaStreamer::Ptr streamer = GetMediaStreamer(rqst.media_name);
+  if (!streamer) {
+    ROS_ERROR("Media streamer could not be found");
+    return true;
+  }
+  BaseMedia::Ptr media = GetMedia(rqst.media_name);
+  if (!media || !media->HasArtificialFramerate()) {
+    ROS_ERROR("The playback of %s cannot be controlled, it is not a file.",
+              rqst.media_name.c_str());
+    return true;
+  }
+
+  MediaClock &clock = streamer->GetClock();
+  if (rqst.action == rqst.PLAY) {
+    clock.Play();
+  } else if (rqst.action == rqst.PAUSE) {
+    clock.Pause();
+  } else if (rqst.action == rqst.STEP) {
+    clock.Step(rqst.step_count > 0 ? rqst.step_count : 1);
+  } else if (rqst.action == rqst.SET_SPEED) {
+    clock.SetSpeed(rqst.speed);
+  } else {
+    ROS_ERROR("The playback action is not supported.");
+    return true;
+  }
+  rep.action_accomplished = true;
+  return true;
+}
+
 }  // namespace provider_vision
@@ -23,7 +23,10 @@
 
 #include <dynamic_reconfigure/server.h>
 #include <provider_vision/media/camera/base_media.h>
+#include <ros/callback_queue.h>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -31,6 +34,7 @@
 #include "provider_vision/start_stop_media.h"
 #include "provider_vision/get_camera_feature.h"
 #include "provider_vision/set_camera_feature.h"
+#include "provider_vision/set_playback.h"
 
 #include "../cfg/cpp/provider_vision/Camera_Parameters_Config.h"
 #include "provider_vision/media/camera/base_camera.h"
@@ -41,6 +45,12 @@ namespace provider_vision {
 
 /*
  * Class to handle media context and create/delete mediastreamers
+ *
+ * Every context has its own callback queue, served by its own thread. The
+ * services post the work on the queue of the context of the media, so a slow
+ * call on a camera (opening a GigE camera can take up to 50 s) never stalls
+ * the calls on the medias of the other contexts, and the calls on a context
+ * are still executed one at a time.
  */
 class MediaManager {
 public:
@@ -143,6 +153,14 @@ private:
 
   bool IsContextValid(const std::string &name);
 
+  /**
+   * Executes the work on the thread of the context and waits for its result.
+   * If there is no context (i.e. the media does not exist), or if this is
+   * already the thread of the context, the work is executed right away.
+   */
+  bool RunOnContext(const BaseContext::Ptr &context,
+                    const std::function<bool()> &work) const;
+
   // All the callbacks
   bool GetAvailableCameraCallback( provider_vision::get_available_cameraRequest &request,
                                    provider_vision::get_available_cameraResponse &response);
@@ -156,16 +174,26 @@ private:
   bool GetCameraFeatureCallback( provider_vision::get_camera_feature::Request &rqst,
                                  provider_vision::get_camera_feature::Response &rep);
 
+  bool SetPlaybackCallback( provider_vision::set_playback::Request &rqst,
+                            provider_vision::set_playback::Response &rep);
+
   //==========================================================================
   // P R I V A T E   M E M B E R S
 
   ros::NodeHandle nh_;
 
   ros::ServiceServer get_available_camera_, start_stop_media_,
-      set_camera_feature_, get_camera_feature_;
+      set_camera_feature_, get_camera_feature_, set_playback_;
 
   std::vector<BaseContext::Ptr> contexts_;
 
+  // One queue and one thread per context, in the order of contexts_.
+  std::vector<std::shared_ptr<ros::CallbackQueue>> context_queues_;
+  std::vector<std::shared_ptr<ros::AsyncSpinner>> context_spinners_;
+
+  // The streamers are started and stopped from the threads of the contexts.
+  mutable std::mutex streamers_access_;
+
   std::vector<MediaStreamer::Ptr> media_streamers_;
 
   dynamic_reconfigure::Server<provider_vision::Camera_Parameters_Config>
@@ -174,12 +202,15 @@ private:
   provider_vision::Camera_Parameters_Config old_config_;
 
   std::string FormatNameForTopic(const std::string &media_name) const;
+
+  std::string FormatNameForParameter(const std::string &media_name) const;
 };
 
 //-----------------------------------------------------------------------------
 //
 inline MediaStreamer::Ptr MediaManager::GetMediaStreamer(
     const std::string &name) {
+  std::lock_guard<std::mutex> guard(streamers_access_);
   MediaStreamer::Ptr media_ptr(nullptr);
 
   for (const auto &elem : media_streamers_) {
@@ -193,17 +224,25 @@ inline MediaStreamer::Ptr MediaManager::GetMediaStreamer(
 //-----------------------------------------------------------------------------
 //
 inline void MediaManager::AddMediaStreamer(MediaStreamer::Ptr media_streamer) {
+  std::lock_guard<std::mutex> guard(streamers_access_);
   media_streamers_.push_back(media_streamer);
 }
 
 //-----------------------------------------------------------------------------
 //
 inline void MediaManager::RemoveMediaStreamer(const std::string &name) {
-  for (auto elem = media_streamers_.begin(); elem != media_streamers_.end();
-       elem++) {
-    if ((*elem)->GetMediaName().compare(name) == 0) {
-      media_streamers_.erase(elem);
-      return;
+  // The streamer joins its threads when it is destroyed, this must not
+  // happen while the list is locked.
+  MediaStreamer::Ptr removed;
+  {
+    std::lock_guard<std::mutex> guard(streamers_access_);
+    for (auto elem = media_streamers_.begin(); elem != media_streamers_.end();
+         elem++) {
+      if ((*elem)->GetMediaName().compare(name) == 0) {
+        removed = *elem;
+        media_streamers_.erase(elem);
+        break;
+      }
     }
   }
 }
@@ -211,6 +250,7 @@ inline void MediaManager::RemoveMediaStreamer(const std::string &name) {
 //-------------------------------------------------------------------------
 //
 inline bool MediaManager::IsMediaStreaming(const std::string &name) {
+  std::lock_guard<std::mutex> guard(streamers_access_);
   for (const auto &elem : media_streamers_) {
     if (name.compare(elem->GetMediaName()) == 0) {
       return true;
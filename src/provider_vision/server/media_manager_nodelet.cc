@@ -0,0 +1,40 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include "provider_vision/server/media_manager_nodelet.h"
+#include <pluginlib/class_list_macros.h>
+
+namespace provider_vision {
+
+//==============================================================================
+// M E T H O D   S E C T I O N
+
+//------------------------------------------------------------------------------
+//
+void MediaManagerNodelet::onInit() {
+  // The services are served by the threads of the nodelet manager, there is
+  // no spinning loop to run like in the node.
+  ros::NodeHandle &nh = getMTPrivateNodeHandle();
+  media_manager_.reset(new MediaManager(nh));
+}
+
+}  // namespace provider_vision
+
+PLUGINLIB_EXPORT_CLASS(provider_vision::MediaManagerNodelet, nodelet::Nodelet)
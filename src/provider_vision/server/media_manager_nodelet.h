@@ -0,0 +1,62 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROVIDER_VISION_SERVER_MEDIA_MANAGER_NODELET_H_
+#define PROVIDER_VISION_SERVER_MEDIA_MANAGER_NODELET_H_
+
+#include <nodelet/nodelet.h>
+#include <memory>
+#include "provider_vision/server/media_manager.h"
+
+namespace provider_vision {
+
+/**
+ * Nodelet version of the provider_vision_node.
+ *
+ * Loading the MediaManager in the same nodelet manager than the image
+ * processing nodes makes the MediaStreamer publish the very buffer of the
+ * converted image to them: the messages are passed as shared pointers, with
+ * no serialization and no copy.
+ * The provider_vision_node is still there for the remote subscribers.
+ */
+class MediaManagerNodelet : public nodelet::Nodelet {
+ public:
+  //==========================================================================
+  // P U B L I C   C / D T O R S
+
+  MediaManagerNodelet() = default;
+
+  virtual ~MediaManagerNodelet() = default;
+
+ private:
+  //==========================================================================
+  // P R I V A T E   M E T H O D S
+
+  void onInit() override;
+
+  //==========================================================================
+  // P R I V A T E   M E M B E R S
+
+  std::unique_ptr<MediaManager> media_manager_;
+};
+
+}  // namespace provider_vision
+
+#endif  // PROVIDER_VISION_SERVER_MEDIA_MANAGER_NODELET_H_
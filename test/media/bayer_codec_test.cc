@@ -0,0 +1,119 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/bayer_codec.h"
+
+using provider_vision::BayerCodec;
+using provider_vision::DecodeBayer;
+using provider_vision::EncodeBayer;
+using provider_vision::GetBayerFormat;
+using provider_vision::ParseBayerFormat;
+
+namespace {
+
+// A smooth scene seen through the filters of the mosaic, with the noise of
+// a sensor.
+cv::Mat MakeMosaic(const cv::Size &size) {
+  cv::Mat scene(size, CV_8UC1);
+  cv::randu(scene, 0, 256);
+  cv::GaussianBlur(scene, scene, cv::Size(31, 31), 8.0);
+  cv::Mat noise(size, CV_8UC1);
+  cv::randu(noise, 0, 6);
+  cv::Mat mosaic = scene + noise;
+  for (int y = 0; y < mosaic.rows; y += 2) {
+    for (int x = 0; x < mosaic.cols; x += 2) {
+      mosaic.at<uchar>(y, x) /= 2;
+    }
+  }
+  return mosaic;
+}
+
+}  // namespace
+
+TEST(BayerCodecTest, lossless_round_trip) {
+  // The strips are 64 rows high, the last one is partial.
+  const cv::Size sizes[] = {cv::Size(1296, 964), cv::Size(34, 6),
+                            cv::Size(2, 2)};
+  for (const cv::Size &size : sizes) {
+    const cv::Mat mosaic = MakeMosaic(size);
+    std::vector<uint8_t> data;
+    ASSERT_TRUE(EncodeBayer(mosaic, BayerCodec::LOSSLESS, 0, 0, data));
+    if (size.area() > 1000) {
+      ASSERT_LT(data.size(), mosaic.total() / 2);
+    }
+    cv::Mat decoded;
+    ASSERT_TRUE(
+        DecodeBayer(data.data(), data.size(), BayerCodec::LOSSLESS, decoded));
+    ASSERT_EQ(decoded.size(), mosaic.size());
+    ASSERT_EQ(cv::countNonZero(decoded != mosaic), 0);
+
+    // A truncated message is rejected.
+    ASSERT_FALSE(DecodeBayer(data.data(), data.size() / 2,
+                             BayerCodec::LOSSLESS, decoded));
+  }
+}
+
+TEST(BayerCodecTest, jpeg_round_trip) {
+  // Planes of 482 and 772 rows, not whole blocks of the JPEG.
+  const cv::Size sizes[] = {cv::Size(1296, 964), cv::Size(2064, 1544)};
+  for (const cv::Size &size : sizes) {
+    const cv::Mat mosaic = MakeMosaic(size);
+    std::vector<uint8_t> data;
+    ASSERT_TRUE(EncodeBayer(mosaic, BayerCodec::JPEG, 90, 2, data));
+    ASSERT_LT(data.size(), mosaic.total() / 4);
+    cv::Mat decoded;
+    ASSERT_TRUE(
+        DecodeBayer(data.data(), data.size(), BayerCodec::JPEG, decoded));
+    ASSERT_EQ(decoded.size(), mosaic.size());
+    ASSERT_GT(cv::PSNR(mosaic, decoded), 35.0);
+  }
+}
+
+TEST(BayerCodecTest, parses_format) {
+  std::string encoding;
+  BayerCodec codec;
+  ASSERT_TRUE(ParseBayerFormat(GetBayerFormat("bayer_rggb8", BayerCodec::JPEG),
+                               encoding, codec));
+  ASSERT_EQ(encoding, "bayer_rggb8");
+  ASSERT_EQ(codec, BayerCodec::JPEG);
+  ASSERT_TRUE(ParseBayerFormat("bayer_grbg8; bayer_lossless", encoding, codec));
+  ASSERT_EQ(codec, BayerCodec::LOSSLESS);
+  ASSERT_FALSE(ParseBayerFormat("bgr8; jpeg compressed bgr8", encoding, codec));
+}
+
+TEST(BayerCodecTest, rejects_invalid_mosaic) {
+  std::vector<uint8_t> data;
+  ASSERT_FALSE(EncodeBayer(cv::Mat(10, 11, CV_8UC1), BayerCodec::LOSSLESS, 0,
+                           0, data));
+  ASSERT_FALSE(EncodeBayer(cv::Mat(10, 10, CV_8UC3), BayerCodec::JPEG, 80, 0,
+                           data));
+  const std::vector<uint8_t> junk(64, 7);
+  cv::Mat decoded;
+  ASSERT_FALSE(
+      DecodeBayer(junk.data(), junk.size(), BayerCodec::LOSSLESS, decoded));
+  ASSERT_FALSE(DecodeBayer(junk.data(), junk.size(), BayerCodec::JPEG, decoded));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
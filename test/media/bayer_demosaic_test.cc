@@ -0,0 +1,159 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/bayer_demosaic.h"
+
+using provider_vision::BayerPattern;
+using provider_vision::DemosaicBilinear;
+using provider_vision::DemosaicBinning;
+using provider_vision::DemosaicRemap;
+using provider_vision::SimdLevel;
+
+namespace {
+
+const BayerPattern kPatterns[] = {BayerPattern::RGGB, BayerPattern::GRBG,
+                                  BayerPattern::GBRG, BayerPattern::BGGR};
+
+// The OpenCV codes of the patterns, named after the second row.
+const int kOpenCvCodes[] = {CV_BayerBG2BGR, CV_BayerGB2BGR, CV_BayerGR2BGR,
+                            CV_BayerRG2BGR};
+
+cv::Mat RandomMosaic(int rows, int cols) {
+  cv::Mat bayer(rows, cols, CV_8UC1);
+  cv::randu(bayer, 0, 256);
+  return bayer;
+}
+
+}  // namespace
+
+TEST(BayerDemosaicTest, kernels_are_identical) {
+  // The odd widths leave a tail to the scalar kernel.
+  const cv::Size sizes[] = {cv::Size(2, 2), cv::Size(37, 29),
+                            cv::Size(333, 31), cv::Size(2064, 16)};
+  for (const cv::Size &size : sizes) {
+    cv::Mat bayer = RandomMosaic(size.height, size.width);
+    for (BayerPattern pattern : kPatterns) {
+      cv::Mat reference, bgr;
+      ASSERT_TRUE(
+          DemosaicBilinear(bayer, pattern, reference, SimdLevel::SCALAR));
+      for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+        ASSERT_TRUE(DemosaicBilinear(bayer, pattern, bgr, level));
+        ASSERT_EQ(cv::countNonZero(reference.reshape(1) != bgr.reshape(1)),
+                  0);
+      }
+    }
+  }
+}
+
+TEST(BayerDemosaicTest, interior_matches_opencv) {
+  cv::Mat bayer = RandomMosaic(64, 250);
+  const cv::Rect interior(1, 1, bayer.cols - 2, bayer.rows - 2);
+  for (int i = 0; i < 4; ++i) {
+    cv::Mat expected, bgr;
+    cv::cvtColor(bayer, expected, kOpenCvCodes[i]);
+    ASSERT_TRUE(DemosaicBilinear(bayer, kPatterns[i], bgr));
+    ASSERT_EQ(cv::norm(expected(interior), bgr(interior), cv::NORM_INF), 0.0);
+  }
+}
+
+TEST(BayerDemosaicTest, flat_color_everywhere) {
+  // A uniform scene must stay uniform, the borders included.
+  const cv::Vec3b color(30, 120, 220);
+  cv::Mat bayer(15, 21, CV_8UC1);
+  for (int y = 0; y < bayer.rows; ++y) {
+    for (int x = 0; x < bayer.cols; ++x) {
+      const bool red = y % 2 == 0 && x % 2 == 0;
+      const bool blue = y % 2 == 1 && x % 2 == 1;
+      bayer.at<uchar>(y, x) = red ? color[2] : blue ? color[0] : color[1];
+    }
+  }
+  cv::Mat bgr;
+  ASSERT_TRUE(DemosaicBilinear(bayer, BayerPattern::RGGB, bgr));
+  for (int y = 0; y < bgr.rows; ++y) {
+    for (int x = 0; x < bgr.cols; ++x) {
+      ASSERT_EQ(bgr.at<cv::Vec3b>(y, x), color);
+    }
+  }
+}
+
+TEST(BayerDemosaicTest, rejects_invalid_mosaic) {
+  cv::Mat bgr;
+  ASSERT_FALSE(DemosaicBilinear(cv::Mat(1, 10, CV_8UC1), BayerPattern::RGGB,
+                                bgr));
+  ASSERT_FALSE(DemosaicBilinear(cv::Mat(10, 10, CV_8UC3), BayerPattern::RGGB,
+                                bgr));
+}
+
+TEST(BayerDemosaicTest, binning_averages_the_greens) {
+  cv::Mat bayer = (cv::Mat_<uchar>(2, 4) << 10, 20, 11, 21, 31, 40, 30, 41);
+  cv::Mat bgr;
+  ASSERT_TRUE(DemosaicBinning(bayer, BayerPattern::RGGB, bgr));
+  ASSERT_EQ(bgr.size(), cv::Size(2, 1));
+  ASSERT_EQ(bgr.at<cv::Vec3b>(0, 0), cv::Vec3b(40, 26, 10));
+  ASSERT_EQ(bgr.at<cv::Vec3b>(0, 1), cv::Vec3b(41, 26, 11));
+}
+
+TEST(BayerDemosaicTest, binning_kernels_are_identical) {
+  cv::Mat bayer = RandomMosaic(31, 333);
+  for (BayerPattern pattern : kPatterns) {
+    cv::Mat reference, bgr;
+    ASSERT_TRUE(DemosaicBinning(bayer, pattern, reference, SimdLevel::SCALAR));
+    ASSERT_EQ(reference.size(), cv::Size(166, 15));
+    ASSERT_TRUE(DemosaicBinning(bayer, pattern, bgr, SimdLevel::AVX2));
+    ASSERT_EQ(cv::countNonZero(reference.reshape(1) != bgr.reshape(1)), 0);
+  }
+}
+
+TEST(BayerDemosaicTest, remap_matches_opencv_remap) {
+  // A strong barrel distortion, so the corners come from out of the mosaic.
+  cv::Mat bayer = RandomMosaic(48, 70);
+  const cv::Mat camera_matrix =
+      (cv::Mat_<double>(3, 3) << 60.0, 0.0, 34.5, 0.0, 60.0, 23.5, 0.0, 0.0,
+       1.0);
+  const cv::Mat distortion =
+      (cv::Mat_<double>(5, 1) << -0.4, 0.2, 0.001, -0.002, 0.0);
+  cv::Mat map1, map2;
+  cv::initUndistortRectifyMap(camera_matrix, distortion, cv::Mat(),
+                              camera_matrix, cv::Size(75, 50), CV_16SC2, map1,
+                              map2);
+  for (BayerPattern pattern : kPatterns) {
+    cv::Mat demosaiced, expected, bgr;
+    ASSERT_TRUE(DemosaicBilinear(bayer, pattern, demosaiced));
+    cv::remap(demosaiced, expected, map1, map2, cv::INTER_LINEAR,
+              cv::BORDER_CONSTANT);
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2}) {
+      ASSERT_TRUE(DemosaicRemap(bayer, pattern, map1, map2, bgr, level));
+      ASSERT_EQ(bgr.size(), cv::Size(75, 50));
+      ASSERT_EQ(cv::norm(expected, bgr, cv::NORM_INF), 0.0);
+    }
+  }
+  // The maps must be the fixed point ones.
+  cv::Mat float_map1, float_map2, bgr;
+  cv::convertMaps(map1, map2, float_map1, float_map2, CV_32FC1);
+  ASSERT_FALSE(DemosaicRemap(bayer, BayerPattern::RGGB, float_map1,
+                             float_map2, bgr));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "provider_vision/media/device_clock.h"
+
+using provider_vision::DeviceClock;
+using provider_vision::GetBlockIdDelta;
+using provider_vision::GetFrameCountDelta;
+
+namespace {
+
+// The device counts in microseconds from its start, 1000 s after the epoch
+// of ROS time.
+const double kTickFrequency = 1e6;
+const double kStart = 1000.0;
+
+uint64_t ToTicks(double device_time) {
+  return static_cast<uint64_t>(std::llround(device_time * kTickFrequency));
+}
+
+}  // namespace
+
+TEST(DeviceClockTest, keeps_the_smallest_delay) {
+  DeviceClock clock(kTickFrequency);
+  for (int i = 0; i < 100; ++i) {
+    const double taken = i * 0.1;
+    // Every tenth frame arrives 1 ms after it is taken, the others up to
+    // 20 ms late.
+    const double delay = i % 10 == 3 ? 0.001 : 0.005 + (i * 7 % 16) * 1e-3;
+    const ros::Time received(kStart + taken + delay);
+    const ros::Time stamp = clock.ToRosTime(ToTicks(taken), received);
+    ASSERT_LE(stamp, received);
+    if (i >= 3) {
+      // The estimate is the smallest delay, a later frame does not make it
+      // worse but by the drift allowance.
+      const double error = stamp.toSec() - (kStart + taken);
+      ASSERT_NEAR(error, 0.001, 1.5e-4);
+    }
+  }
+}
+
+TEST(DeviceClockTest, follows_the_drift) {
+  DeviceClock clock(kTickFrequency);
+  // The device clock is 50 ppm slow, the offset grows by 50 us/s. The frames
+  // arrive 2 ms after they are taken, 12 ms for most of them.
+  for (int i = 0; i < 2000; ++i) {
+    const double taken = i * 0.5;
+    const double delay = i % 8 == 0 ? 0.002 : 0.012;
+    const ros::Time received(kStart + taken + delay);
+    const ros::Time stamp =
+        clock.ToRosTime(ToTicks(taken * (1.0 - 50e-6)), received);
+    ASSERT_LE(stamp, received);
+    const double error = stamp.toSec() - (kStart + taken);
+    ASSERT_NEAR(error, 0.002, 5e-4);
+  }
+}
+
+TEST(DeviceClockTest, resets_when_the_ticks_go_back) {
+  DeviceClock clock(kTickFrequency);
+  clock.ToRosTime(ToTicks(10.0), ros::Time(kStart + 10.0));
+  ASSERT_NEAR(clock.ToRosTime(ToTicks(11.0), ros::Time(kStart + 11.5)).toSec(),
+              kStart + 11.0, 1e-3);
+
+  // The device restarted, its clock is back to 0 and the old offset would
+  // put the frame 1000 s in the past.
+  const ros::Time received(kStart + 20.0);
+  const ros::Time stamp = clock.ToRosTime(ToTicks(0.5), received);
+  ASSERT_NEAR(stamp.toSec(), received.toSec(), 1e-6);
+  ASSERT_NEAR(clock.ToRosTime(ToTicks(1.5), ros::Time(kStart + 21.0)).toSec(),
+              kStart + 21.0, 1e-6);
+
+  // Another frequency is another clock as well.
+  clock.SetTickFrequency(2 * kTickFrequency);
+  const ros::Time later(kStart + 30.0);
+  ASSERT_NEAR(clock.ToRosTime(ToTicks(2.0), later).toSec(), later.toSec(),
+              1e-6);
+}
+
+TEST(DeviceClockTest, unwraps_the_block_ids) {
+  ASSERT_EQ(GetBlockIdDelta(1, 2), 1);
+  ASSERT_EQ(GetBlockIdDelta(10, 14), 4);
+  // 0 is skipped when the 16 bits ids wrap.
+  ASSERT_EQ(GetBlockIdDelta(65535, 1), 1);
+  ASSERT_EQ(GetBlockIdDelta(65534, 2), 3);
+  ASSERT_EQ(GetBlockIdDelta(7, 7), 65535);
+}
+
+TEST(DeviceClockTest, counts_the_frames_from_the_timestamps) {
+  const double interval = 1.0 / 30.0;
+  ASSERT_EQ(GetFrameCountDelta(1000000, 1033333, interval), 1);
+  // A little jitter is still the next frame, and so is a frame too early.
+  ASSERT_EQ(GetFrameCountDelta(1000000, 1040000, interval), 1);
+  ASSERT_EQ(GetFrameCountDelta(1000000, 1010000, interval), 1);
+  // Two frames lost.
+  ASSERT_EQ(GetFrameCountDelta(1000000, 1100000, interval), 3);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,65 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/downsample.h"
+
+using provider_vision::DownsampleBox;
+using provider_vision::SimdLevel;
+
+TEST(DownsampleTest, matches_opencv_area) {
+  for (int type : {CV_8UC1, CV_8UC3, CV_8UC4}) {
+    cv::Mat image(40, 2064, type);
+    cv::randu(image, 0, 256);
+    cv::Mat expected, half;
+    cv::resize(image, expected, cv::Size(1032, 20), 0, 0, cv::INTER_AREA);
+    ASSERT_TRUE(DownsampleBox(image, half));
+    ASSERT_EQ(half.type(), type);
+    ASSERT_EQ(cv::norm(expected, half, cv::NORM_INF), 0.0);
+  }
+}
+
+TEST(DownsampleTest, kernels_are_identical) {
+  // The odd sizes drop the last row and column, and leave a tail to the
+  // scalar kernel.
+  const cv::Size sizes[] = {cv::Size(2, 2), cv::Size(37, 29),
+                            cv::Size(333, 31)};
+  for (const cv::Size &size : sizes) {
+    cv::Mat image(size, CV_8UC3);
+    cv::randu(image, 0, 256);
+    cv::Mat reference, half;
+    ASSERT_TRUE(DownsampleBox(image, reference, SimdLevel::SCALAR));
+    ASSERT_EQ(reference.size(), cv::Size(size.width / 2, size.height / 2));
+    ASSERT_TRUE(DownsampleBox(image, half, SimdLevel::AVX2));
+    ASSERT_EQ(cv::countNonZero(reference.reshape(1) != half.reshape(1)), 0);
+  }
+}
+
+TEST(DownsampleTest, rejects_invalid_image) {
+  cv::Mat half;
+  ASSERT_FALSE(DownsampleBox(cv::Mat(1, 10, CV_8UC3), half));
+  ASSERT_FALSE(DownsampleBox(cv::Mat(10, 10, CV_32FC1), half));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,81 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include "provider_vision/media/frame_pool.h"
+
+using provider_vision::FramePool;
+
+TEST(FramePoolTest, recycles_released_buffers) {
+  FramePool pool(2);
+  pool.Reserve(4, 6, CV_8UC3);
+  ASSERT_EQ(pool.AllocationCount(), 2u);
+
+  cv::Mat image;
+  sensor_msgs::ImagePtr first = pool.Acquire(4, 6, CV_8UC3, image);
+  ASSERT_EQ(image.data, first->data.data());
+  ASSERT_EQ(first->step, 18u);
+  const uint8_t *buffer = first->data.data();
+
+  // The first buffer is still referenced, the second one is handed out.
+  sensor_msgs::ImagePtr second = pool.Acquire(4, 6, CV_8UC3, image);
+  ASSERT_NE(second->data.data(), buffer);
+
+  first.reset();
+  sensor_msgs::ImagePtr third = pool.Acquire(4, 6, CV_8UC3, image);
+  ASSERT_EQ(third->data.data(), buffer);
+  ASSERT_EQ(pool.AllocationCount(), 2u);
+}
+
+TEST(FramePoolTest, grows_when_exhausted) {
+  FramePool pool(1);
+  pool.Reserve(2, 2, CV_8UC1);
+
+  cv::Mat image;
+  sensor_msgs::ImagePtr first = pool.Acquire(2, 2, CV_8UC1, image);
+  sensor_msgs::ImagePtr second = pool.Acquire(2, 2, CV_8UC1, image);
+  ASSERT_NE(first, second);
+  ASSERT_EQ(pool.AllocationCount(), 2u);
+
+  // The new buffer was kept by the pool.
+  const uint8_t *buffer = second->data.data();
+  second.reset();
+  sensor_msgs::ImagePtr third = pool.Acquire(2, 2, CV_8UC1, image);
+  ASSERT_EQ(third->data.data(), buffer);
+  ASSERT_EQ(pool.AllocationCount(), 2u);
+}
+
+TEST(FramePoolTest, replaces_buffers_of_another_geometry) {
+  FramePool pool(2);
+  pool.Reserve(2, 2, CV_8UC1);
+
+  cv::Mat image;
+  sensor_msgs::ImagePtr msg = pool.Acquire(3, 3, CV_8UC3, image);
+  ASSERT_EQ(image.rows, 3);
+  ASSERT_EQ(image.cols, 3);
+  ASSERT_EQ(image.type(), CV_8UC3);
+  ASSERT_EQ(msg->data.size(), 27u);
+  ASSERT_EQ(pool.AllocationCount(), 3u);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/jpeg_encoder.h"
+#include "provider_vision/media/conversion/yuv422.h"
+#include "provider_vision/media/work_pool.h"
+
+using provider_vision::ConvertUyvyToBgr;
+using provider_vision::EncodeJpeg;
+using provider_vision::WorkPool;
+
+namespace {
+
+// Smooth enough to compress as a photo would.
+cv::Mat MakeImage(const cv::Size &size, int type) {
+  cv::Mat image(size, type);
+  cv::randu(image, 0, 256);
+  cv::blur(image, image, cv::Size(9, 9));
+  return image;
+}
+
+}  // namespace
+
+TEST(JpegEncoderTest, strips_match_serial_encoding) {
+  const cv::Size sizes[] = {cv::Size(2048, 1536), cv::Size(640, 481),
+                            cv::Size(38, 29)};
+  for (const cv::Size &size : sizes) {
+    for (int type : {CV_8UC1, CV_8UC2, CV_8UC3}) {
+      const cv::Mat image = MakeImage(size, type);
+      for (int restart_rows : {1, 3}) {
+        std::vector<uint8_t> serial, strips;
+        WorkPool::Instance().SetThreadCount(0);
+        ASSERT_TRUE(EncodeJpeg(image, 85, restart_rows, serial));
+        WorkPool::Instance().SetThreadCount(3);
+        ASSERT_TRUE(EncodeJpeg(image, 85, restart_rows, strips));
+        ASSERT_EQ(serial, strips);
+      }
+    }
+  }
+}
+
+TEST(JpegEncoderTest, decodes_to_image) {
+  const cv::Mat bgr = MakeImage(cv::Size(640, 480), CV_8UC3);
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(EncodeJpeg(bgr, 90, 2, jpeg));
+  const cv::Mat decoded = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+  ASSERT_EQ(decoded.size(), bgr.size());
+  ASSERT_GT(cv::PSNR(bgr, decoded), 30.0);
+
+  // The YUV422 image is encoded as it is, it decodes to its BGR conversion.
+  const cv::Mat uyvy = MakeImage(cv::Size(640, 480), CV_8UC2);
+  cv::Mat converted;
+  ASSERT_TRUE(ConvertUyvyToBgr(uyvy, converted));
+  ASSERT_TRUE(EncodeJpeg(uyvy, 90, 0, jpeg));
+  ASSERT_GT(cv::PSNR(converted, cv::imdecode(jpeg, cv::IMREAD_COLOR)), 30.0);
+}
+
+TEST(JpegEncoderTest, rejects_invalid_image) {
+  std::vector<uint8_t> jpeg;
+  ASSERT_FALSE(EncodeJpeg(cv::Mat(), 80, 0, jpeg));
+  ASSERT_FALSE(EncodeJpeg(cv::Mat(10, 11, CV_8UC2), 80, 0, jpeg));
+  ASSERT_FALSE(EncodeJpeg(cv::Mat(10, 10, CV_32FC1), 80, 0, jpeg));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "provider_vision/media/latency_histogram.h"
+
+using provider_vision::LatencyHistogram;
+
+TEST(LatencyHistogramTest, empty_summary) {
+  LatencyHistogram histogram;
+  LatencyHistogram::Summary summary = histogram.TakeSummary();
+  ASSERT_EQ(summary.count, 0u);
+  ASSERT_EQ(summary.p99, 0.0);
+  ASSERT_EQ(summary.max, 0.0);
+}
+
+TEST(LatencyHistogramTest, percentiles_within_a_bucket) {
+  LatencyHistogram histogram;
+  // 1 ms to 100 ms, one sample per millisecond.
+  for (int i = 1; i <= 100; ++i) {
+    histogram.Record(i * 1e-3);
+  }
+  LatencyHistogram::Summary summary = histogram.TakeSummary();
+  ASSERT_EQ(summary.count, 100u);
+  ASSERT_DOUBLE_EQ(summary.max, 0.1);
+  // The percentiles are the upper bound of their bucket, at most 25% above.
+  ASSERT_GE(summary.p50, 0.050);
+  ASSERT_LE(summary.p50, 0.050 * 1.25);
+  ASSERT_GE(summary.p95, 0.095);
+  ASSERT_LE(summary.p95, 0.1);
+  ASSERT_GE(summary.p99, 0.099);
+  ASSERT_LE(summary.p99, 0.1);
+
+  // The summary starts over.
+  ASSERT_EQ(histogram.TakeSummary().count, 0u);
+}
+
+TEST(LatencyHistogramTest, concurrent_records) {
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (int i = 0; i < 10000; ++i) {
+        histogram.Record((t + 1) * 1e-3);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  LatencyHistogram::Summary summary = histogram.TakeSummary();
+  ASSERT_EQ(summary.count, 40000u);
+  ASSERT_DOUBLE_EQ(summary.max, 0.004);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
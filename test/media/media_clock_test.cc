@@ -0,0 +1,112 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "provider_vision/media/media_clock.h"
+
+using provider_vision::MediaClock;
+
+namespace {
+
+double ElapsedSeconds(const MediaClock::Clock::time_point &start) {
+  return std::chrono::duration<double>(MediaClock::Clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+TEST(MediaClockTest, unpaced_does_not_wait) {
+  std::atomic<bool> stop(false);
+  MediaClock clock(30.0, 0.0);
+  const auto start = MediaClock::Clock::now();
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(clock.WaitNextFrame(stop));
+  }
+  ASSERT_LT(ElapsedSeconds(start), 0.05);
+}
+
+TEST(MediaClockTest, paces_at_frame_rate_times_speed) {
+  std::atomic<bool> stop(false);
+  // 50 fps at twice the speed, a frame every 10 ms.
+  MediaClock clock(50.0, 2.0);
+  const auto start = MediaClock::Clock::now();
+  for (int i = 0; i < 11; ++i) {
+    ASSERT_TRUE(clock.WaitNextFrame(stop));
+  }
+  // The first frame is due right away, the ten others every 10 ms.
+  const double elapsed = ElapsedSeconds(start);
+  ASSERT_GE(elapsed, 0.095);
+  ASSERT_LT(elapsed, 0.2);
+}
+
+TEST(MediaClockTest, deadlines_do_not_drift) {
+  std::atomic<bool> stop(false);
+  MediaClock clock(100.0, 1.0);
+  const auto start = MediaClock::Clock::now();
+  for (int i = 0; i < 21; ++i) {
+    ASSERT_TRUE(clock.WaitNextFrame(stop));
+    // Less than a period of work per frame must not add up.
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  const double elapsed = ElapsedSeconds(start);
+  ASSERT_GE(elapsed, 0.2);
+  ASSERT_LT(elapsed, 0.25);
+}
+
+TEST(MediaClockTest, steps_while_paused) {
+  std::atomic<bool> stop(false);
+  MediaClock clock(1000.0, 1.0);
+  clock.Step(2);
+  ASSERT_TRUE(clock.IsPaused());
+  ASSERT_TRUE(clock.WaitNextFrame(stop));
+  ASSERT_TRUE(clock.WaitNextFrame(stop));
+
+  // No step left, the clock waits until it is played again.
+  std::atomic<bool> delivered(false);
+  std::thread consumer([&]() {
+    clock.WaitNextFrame(stop);
+    delivered = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(delivered);
+  clock.Play();
+  consumer.join();
+  ASSERT_TRUE(delivered);
+}
+
+TEST(MediaClockTest, stop_interrupts_the_wait) {
+  std::atomic<bool> stop(false);
+  MediaClock clock(1.0, 1.0);
+  clock.Pause();
+  std::thread stopper([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop = true;
+  });
+  ASSERT_FALSE(clock.WaitNextFrame(stop));
+  stopper.join();
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include "provider_vision/media/camera/video_file.h"
+#include "provider_vision/media/frame_pool.h"
+#include "provider_vision/media/media_recorder.h"
+
+using provider_vision::FramePool;
+using provider_vision::MediaRecorder;
+using provider_vision::VideoFile;
+
+TEST(MediaRecorderTest, records_a_playable_video) {
+  char directory[] = "/tmp/media_recorder_testXXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+  const std::string path = MediaRecorder::MakePath(directory, "front/camera");
+  ASSERT_EQ(path.find("front/camera"), std::string::npos);
+
+  const int frame_count = 20;
+  {
+    // MPEG-4 part 2 is always built in FFmpeg. The queue holds all the
+    // frames, none of them is dropped.
+    MediaRecorder recorder(path, "mp4v", 10.0, frame_count);
+    FramePool pool(2);
+    for (int i = 0; i < frame_count; ++i) {
+      cv::Mat image;
+      sensor_msgs::ImagePtr message = pool.Acquire(96, 128, CV_8UC3, image);
+      image = cv::Scalar(i * 10, 128, 255 - i * 10);
+      message->encoding = sensor_msgs::image_encodings::BGR8;
+      message->header.seq = static_cast<uint32_t>(100 + i);
+      message->header.stamp = ros::Time(1000 + i, 500);
+      ASSERT_TRUE(recorder.Record(message));
+    }
+  }
+
+  VideoFile video(path, false);
+  ASSERT_TRUE(video.Open());
+  cv::Mat image;
+  int decoded = 0;
+  while (video.NextImage(image)) {
+    ASSERT_EQ(image.size(), cv::Size(128, 96));
+    ++decoded;
+  }
+  ASSERT_EQ(decoded, frame_count);
+
+  std::ifstream index((path + ".csv").c_str());
+  std::string line;
+  ASSERT_TRUE(std::getline(index, line));
+  ASSERT_EQ(line, "frame,sequence,stamp");
+  for (int i = 0; i < frame_count; ++i) {
+    ASSERT_TRUE(std::getline(index, line));
+    ASSERT_EQ(line, std::to_string(i) + "," + std::to_string(100 + i) + "," +
+                        std::to_string(1000 + i) + ".000000500");
+  }
+  ASSERT_FALSE(std::getline(index, line));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
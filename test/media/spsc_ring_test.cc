@@ -0,0 +1,143 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "provider_vision/media/spsc_ring.h"
+
+using provider_vision::SpscRing;
+
+TEST(SpscRingTest, push_pop_in_order) {
+  SpscRing<int> ring(3);
+  for (int i = 0; i < 3; ++i) {
+    int value = i;
+    ASSERT_TRUE(ring.TryPush(value));
+  }
+  // The ring is full, the value must not be consumed.
+  int value = 42;
+  ASSERT_FALSE(ring.TryPush(value));
+  ASSERT_EQ(value, 42);
+  ASSERT_EQ(ring.Size(), 3u);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(ring.TryPop(value));
+    ASSERT_EQ(value, i);
+  }
+  ASSERT_FALSE(ring.TryPop(value));
+}
+
+TEST(SpscRingTest, drop_policy) {
+  std::atomic<bool> stop(false);
+  SpscRing<int> ring(2);
+  ring.SetDropPolicy(SpscRing<int>::DropPolicy::DROP);
+  for (int i = 0; i < 5; ++i) {
+    int value = i;
+    ring.Push(value, stop);
+  }
+  ASSERT_EQ(ring.DroppedCount(), 3u);
+
+  // The oldest values are kept, the incoming ones were dropped.
+  int value;
+  ASSERT_TRUE(ring.Pop(value, stop));
+  ASSERT_EQ(value, 0);
+}
+
+TEST(SpscRingTest, keep_latest_policy) {
+  std::atomic<bool> stop(false);
+  SpscRing<int> ring(2);
+  ring.SetDropPolicy(SpscRing<int>::DropPolicy::KEEP_LATEST);
+  // More than the capacity, the newest value is the one popped.
+  for (int i = 0; i < 5; ++i) {
+    int value = i;
+    ASSERT_TRUE(ring.Push(value, stop));
+  }
+  ASSERT_EQ(ring.Size(), 1u);
+  int value;
+  ASSERT_TRUE(ring.Pop(value, stop));
+  ASSERT_EQ(value, 4);
+  ASSERT_EQ(ring.DroppedCount(), 4u);
+  ASSERT_EQ(ring.Size(), 0u);
+  ASSERT_FALSE(ring.TryPop(value));
+
+  value = 5;
+  ASSERT_TRUE(ring.Push(value, stop));
+  ASSERT_TRUE(ring.Pop(value, stop));
+  ASSERT_EQ(value, 5);
+}
+
+TEST(SpscRingTest, blocking_producer_consumer) {
+  std::atomic<bool> stop(false);
+  SpscRing<int> ring(4);
+  const int count = 100000;
+
+  std::thread producer([&]() {
+    for (int i = 0; i < count; ++i) {
+      int value = i;
+      ring.Push(value, stop);
+    }
+  });
+
+  // With the BLOCK policy, every value arrives and in order.
+  int expected = 0;
+  int value;
+  while (expected < count && ring.Pop(value, stop)) {
+    ASSERT_EQ(value, expected);
+    ++expected;
+  }
+  producer.join();
+  ASSERT_EQ(ring.DroppedCount(), 0u);
+}
+
+TEST(SpscRingTest, sleeping_stages_are_woken) {
+  std::atomic<bool> stop(false);
+  SpscRing<int> ring(1);
+
+  // The consumer is asleep on the empty ring long before the value comes.
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int value = 1;
+    ring.Push(value, stop);
+    // The ring is full, the producer sleeps until the consumer takes it.
+    value = 2;
+    ring.Push(value, stop);
+  });
+  int value;
+  ASSERT_TRUE(ring.Pop(value, stop));
+  ASSERT_EQ(value, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(ring.Pop(value, stop));
+  ASSERT_EQ(value, 2);
+  producer.join();
+
+  // A stop wakes a sleeping consumer.
+  std::thread stopper([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stop = true;
+  });
+  ASSERT_FALSE(ring.Pop(value, stop));
+  stopper.join();
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
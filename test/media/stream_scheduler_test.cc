@@ -0,0 +1,119 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include "provider_vision/media/stream_scheduler.h"
+
+using provider_vision::StreamScheduler;
+
+namespace {
+
+const StreamScheduler::Clock::duration kFramePeriod =
+    std::chrono::microseconds(33333);
+
+StreamScheduler::Policy MakePolicy(int priority, double target_fps,
+                                   double max_latency) {
+  StreamScheduler::Policy policy;
+  policy.priority = priority;
+  policy.target_fps = target_fps;
+  policy.max_latency = max_latency;
+  return policy;
+}
+
+}  // namespace
+
+TEST(StreamSchedulerTest, admits_target_rate) {
+  StreamScheduler scheduler;
+  const int every_frame = scheduler.Register("every", MakePolicy(0, 0.0, 0.0));
+  const int half_rate = scheduler.Register("half", MakePolicy(0, 15.0, 0.0));
+  const int two_thirds = scheduler.Register("third", MakePolicy(0, 20.0, 0.0));
+
+  int admitted[3] = {0, 0, 0};
+  StreamScheduler::Clock::time_point now;
+  for (int i = 0; i < 300; ++i) {
+    now += kFramePeriod;
+    admitted[0] += scheduler.Admit(every_frame, now);
+    admitted[1] += scheduler.Admit(half_rate, now);
+    admitted[2] += scheduler.Admit(two_thirds, now);
+  }
+  ASSERT_EQ(admitted[0], 300);
+  ASSERT_NEAR(admitted[1], 150, 2);
+  ASSERT_NEAR(admitted[2], 200, 2);
+  ASSERT_EQ(scheduler.GetSkippedCount(half_rate), 300u - admitted[1]);
+}
+
+TEST(StreamSchedulerTest, throttles_lower_priorities_of_late_stream) {
+  StreamScheduler scheduler(std::chrono::milliseconds(100));
+  const int front = scheduler.Register("front", MakePolicy(2, 30.0, 0.05));
+  const int bottom = scheduler.Register("bottom", MakePolicy(1, 30.0, 0.0));
+  const int other = scheduler.Register("other", MakePolicy(2, 30.0, 0.0));
+
+  StreamScheduler::Clock::time_point now;
+  int admitted = 0;
+  for (int i = 0; i < 90; ++i) {
+    now += kFramePeriod;
+    scheduler.Admit(front, now);
+    scheduler.Admit(other, now);
+    admitted += scheduler.Admit(bottom, now);
+    scheduler.ReportLatency(front, 0.08);
+  }
+  // The bottom camera is down to its minimal rate, the camera of the same
+  // priority is left alone.
+  ASSERT_LT(scheduler.GetShare(bottom), 0.1);
+  ASSERT_EQ(scheduler.GetShare(other), 1.0);
+  ASSERT_EQ(scheduler.GetShare(front), 1.0);
+  ASSERT_LT(admitted, 45);
+
+  // Back to its rate once the front camera keeps its deadline.
+  for (int i = 0; i < 150; ++i) {
+    now += kFramePeriod;
+    scheduler.Admit(front, now);
+    scheduler.Admit(bottom, now);
+    scheduler.ReportLatency(front, 0.02);
+  }
+  ASSERT_EQ(scheduler.GetShare(bottom), 1.0);
+}
+
+TEST(StreamSchedulerTest, keeps_minimal_rate) {
+  StreamScheduler scheduler(std::chrono::milliseconds(100));
+  const int front = scheduler.Register("front", MakePolicy(1, 0.0, 0.05));
+  StreamScheduler::Policy policy = MakePolicy(0, 0.0, 0.0);
+  policy.min_fps = 5.0;
+  const int bottom = scheduler.Register("bottom", policy);
+
+  StreamScheduler::Clock::time_point now;
+  int admitted = 0;
+  for (int i = 0; i < 600; ++i) {
+    now += kFramePeriod;
+    scheduler.Admit(front, now);
+    // The last 10 seconds, once throttled.
+    if (scheduler.Admit(bottom, now) && i >= 300) {
+      ++admitted;
+    }
+    scheduler.ReportLatency(front, 0.1);
+  }
+  ASSERT_NEAR(admitted, 50, 2);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
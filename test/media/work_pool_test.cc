@@ -0,0 +1,129 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "provider_vision/media/work_pool.h"
+
+using provider_vision::WorkPool;
+
+namespace {
+
+// Counts the times every row is visited.
+class CountBody : public cv::ParallelLoopBody {
+ public:
+  explicit CountBody(std::vector<std::atomic<int>> &counts)
+      : counts_(counts) {}
+
+  void operator()(const cv::Range &range) const override {
+    for (int i = range.start; i < range.end; ++i) {
+      ++counts_[i];
+    }
+  }
+
+ private:
+  std::vector<std::atomic<int>> &counts_;
+};
+
+bool RunCounted(WorkPool &pool, int rows, int band_rows) {
+  std::vector<std::atomic<int>> counts(rows);
+  for (auto &count : counts) {
+    count = 0;
+  }
+  pool.ParallelFor(cv::Range(0, rows), CountBody(counts), band_rows);
+  for (const auto &count : counts) {
+    if (count != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(WorkPoolTest, visits_every_row_once) {
+  WorkPool pool(3);
+  for (int band_rows = 0; band_rows < 8; ++band_rows) {
+    ASSERT_TRUE(RunCounted(pool, 1037, band_rows));
+  }
+  pool.SetThreadCount(0);
+  ASSERT_EQ(pool.GetThreadCount(), 0u);
+  ASSERT_TRUE(RunCounted(pool, 1037, 0));
+}
+
+TEST(WorkPoolTest, shares_threads_between_callers) {
+  WorkPool pool(2);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.push_back(std::thread([&pool, &failures]() {
+      for (int j = 0; j < 200; ++j) {
+        if (!RunCounted(pool, 500 + j, j % 5)) {
+          ++failures;
+        }
+      }
+    }));
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  ASSERT_EQ(failures, 0);
+}
+
+TEST(WorkPoolTest, runs_nested_jobs) {
+  WorkPool pool(2);
+  std::atomic<int> failures(0);
+  struct NestedBody : public cv::ParallelLoopBody {
+    WorkPool *pool;
+    std::atomic<int> *failures;
+    void operator()(const cv::Range &range) const override {
+      for (int i = range.start; i < range.end; ++i) {
+        if (!RunCounted(*pool, 64, 4)) {
+          ++*failures;
+        }
+      }
+    }
+  } body;
+  body.pool = &pool;
+  body.failures = &failures;
+  pool.ParallelFor(cv::Range(0, 32), body, 1);
+  ASSERT_EQ(failures, 0);
+}
+
+TEST(WorkPoolTest, throws_exception_of_body) {
+  WorkPool pool(2);
+  struct ThrowingBody : public cv::ParallelLoopBody {
+    void operator()(const cv::Range &range) const override {
+      if (range.start == 5) {
+        throw std::runtime_error("band 5");
+      }
+    }
+  } body;
+  ASSERT_THROW(pool.ParallelFor(cv::Range(0, 20), body, 1),
+               std::runtime_error);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
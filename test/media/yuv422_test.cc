@@ -0,0 +1,72 @@
+/// \author	Pierluc Bédard <pierlucbed@gmail.com>
+/// \author	Jérémie St-Jules Prévôt <jeremie.st.jules.prevost@gmail.com>
+/// \author	Thibaut Mattio <thibaut.mattio@gmail.com>
+/// \copyright Copyright (c) 2015 S.O.N.I.A. All rights reserved.
+/// \section LICENSE
+/// This file is part of S.O.N.I.A. software.
+///
+/// S.O.N.I.A. software is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// S.O.N.I.A. software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with S.O.N.I.A. software. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "provider_vision/media/conversion/yuv422.h"
+
+using provider_vision::ConvertUyvyToBgr;
+using provider_vision::SimdLevel;
+
+TEST(Yuv422Test, kernels_are_identical) {
+  // The widths leave a tail to the scalar kernel.
+  for (int width : {2, 30, 34, 658}) {
+    cv::Mat uyvy(7, width, CV_8UC2);
+    cv::randu(uyvy, 0, 256);
+    cv::Mat reference, bgr;
+    ASSERT_TRUE(ConvertUyvyToBgr(uyvy, reference, SimdLevel::SCALAR));
+    for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+      ASSERT_TRUE(ConvertUyvyToBgr(uyvy, bgr, level));
+      ASSERT_EQ(cv::countNonZero(reference.reshape(1) != bgr.reshape(1)), 0);
+    }
+  }
+}
+
+TEST(Yuv422Test, matches_opencv) {
+  cv::Mat uyvy(48, 640, CV_8UC2);
+  cv::randu(uyvy, 0, 256);
+  cv::Mat expected, bgr;
+  cv::cvtColor(uyvy, expected, CV_YUV2BGR_UYVY);
+  ASSERT_TRUE(ConvertUyvyToBgr(uyvy, bgr));
+  ASSERT_EQ(cv::norm(expected, bgr, cv::NORM_INF), 0.0);
+}
+
+TEST(Yuv422Test, gray_levels) {
+  // Video range: the luma 16 is black, 128 a mid gray and 235 white.
+  cv::Mat uyvy = (cv::Mat_<cv::Vec2b>(1, 4) << cv::Vec2b(128, 16),
+                  cv::Vec2b(128, 128), cv::Vec2b(128, 235),
+                  cv::Vec2b(128, 235));
+  cv::Mat bgr;
+  ASSERT_TRUE(ConvertUyvyToBgr(uyvy, bgr));
+  ASSERT_EQ(bgr.at<cv::Vec3b>(0, 0), cv::Vec3b(0, 0, 0));
+  ASSERT_EQ(bgr.at<cv::Vec3b>(0, 1), cv::Vec3b(130, 130, 130));
+  ASSERT_EQ(bgr.at<cv::Vec3b>(0, 2), cv::Vec3b(255, 255, 255));
+}
+
+TEST(Yuv422Test, rejects_invalid_image) {
+  cv::Mat bgr;
+  ASSERT_FALSE(ConvertUyvyToBgr(cv::Mat(4, 5, CV_8UC2), bgr));
+  ASSERT_FALSE(ConvertUyvyToBgr(cv::Mat(4, 4, CV_8UC1), bgr));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}